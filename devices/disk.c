@@ -1,6 +1,7 @@
 #include "devices/disk.h"
 #include <ctype.h>
 #include <debug.h>
+#include <inttypes.h>
 #include <stdbool.h>
 #include <stdio.h>
 #include "devices/timer.h"
@@ -32,6 +33,7 @@
 #define STA_BSY 0x80            /* Busy. */
 #define STA_DRDY 0x40           /* Device Ready. */
 #define STA_DRQ 0x08            /* Data Request. */
+#define STA_ERR 0x01            /* Error. */
 
 /* Control Register bits. */
 #define CTL_SRST 0x04           /* Software Reset. */
@@ -47,6 +49,16 @@
 #define CMD_IDENTIFY_DEVICE 0xec        /* IDENTIFY DEVICE. */
 #define CMD_READ_SECTOR_RETRY 0x20      /* READ SECTOR with retries. */
 #define CMD_WRITE_SECTOR_RETRY 0x30     /* WRITE SECTOR with retries. */
+#define CMD_READ_MULTIPLE 0xc4          /* READ MULTIPLE. */
+#define CMD_WRITE_MULTIPLE 0xc5         /* WRITE MULTIPLE. */
+#define CMD_SET_MULTIPLE_MODE 0xc6      /* SET MULTIPLE MODE. */
+
+/* Largest number of sectors moved per READ/WRITE MULTIPLE data
+   block that we ask a device for. */
+#define MULTIPLE_MAX 16
+
+/* The sector count register is 8 bits wide, 0 meaning 256. */
+#define SECTORS_PER_CMD 256
 
 /* An ATA device. */
 struct disk {
@@ -56,9 +68,12 @@ struct disk {
 
 	bool is_ata;                /* 1=This device is an ATA disk. */
 	disk_sector_t capacity;     /* Capacity in sectors (if is_ata). */
+	int multiple;               /* Sectors per DRQ block, 1 if no
+								   READ/WRITE MULTIPLE. */
 
 	long long read_cnt;         /* Number of sectors read. */
 	long long write_cnt;        /* Number of sectors written. */
+	int64_t io_ns;              /* Nanoseconds spent in reads and writes. */
 };
 
 /* An ATA channel (aka controller).
@@ -71,7 +86,8 @@ struct channel {
 	struct lock lock;           /* Must acquire to access the controller. */
 	bool expecting_interrupt;   /* True if an interrupt is expected, false if
 								   any interrupt would be spurious. */
-	struct semaphore completion_wait;   /* Up'd by interrupt handler. */
+	bool completed;             /* Set by interrupt handler for bottom half. */
+	struct semaphore completion_wait;   /* Up'd by interrupt bottom half. */
 
 	struct disk devices[2];     /* The devices on this channel. */
 };
@@ -84,7 +100,8 @@ static void reset_channel (struct channel *);
 static bool check_device_type (struct disk *);
 static void identify_ata_device (struct disk *);
 
-static void select_sector (struct disk *, disk_sector_t);
+static void set_multiple_mode (struct disk *, const uint16_t id[]);
+static void select_sector (struct disk *, disk_sector_t, size_t cnt);
 static void issue_pio_command (struct channel *, uint8_t command);
 static void input_sector (struct channel *, void *);
 static void output_sector (struct channel *, const void *);
@@ -95,12 +112,15 @@ static void select_device (const struct disk *);
 static void select_device_wait (const struct disk *);
 
 static void interrupt_handler (struct intr_frame *);
+static void disk_softirq (void);
 
 /* Initialize the disk subsystem and detect disks. */
 void
 disk_init (void) {
 	size_t chan_no;
 
+	softirq_register (SOFTIRQ_DISK, disk_softirq);
+
 	for (chan_no = 0; chan_no < CHANNEL_CNT; chan_no++) {
 		struct channel *c = &channels[chan_no];
 		int dev_no;
@@ -121,6 +141,7 @@ disk_init (void) {
 		}
 		lock_init (&c->lock);
 		c->expecting_interrupt = false;
+		c->completed = false;
 		sema_init (&c->completion_wait, 0);
 
 		/* Initialize devices. */
@@ -132,8 +153,10 @@ disk_init (void) {
 
 			d->is_ata = false;
 			d->capacity = 0;
+			d->multiple = 1;
 
 			d->read_cnt = d->write_cnt = 0;
+			d->io_ns = 0;
 		}
 
 		/* Register interrupt handler. */
@@ -167,8 +190,8 @@ disk_print_stats (void) {
 		for (dev_no = 0; dev_no < 2; dev_no++) {
 			struct disk *d = disk_get (chan_no, dev_no);
 			if (d != NULL && d->is_ata)
-				printf ("%s: %lld reads, %lld writes\n",
-						d->name, d->read_cnt, d->write_cnt);
+				printf ("%s: %lld reads, %lld writes, %"PRId64" ns\n",
+						d->name, d->read_cnt, d->write_cnt, d->io_ns);
 		}
 	}
 }
@@ -209,44 +232,110 @@ disk_size (struct disk *d) {
    per-disk locking is unneeded. */
 void
 disk_read (struct disk *d, disk_sector_t sec_no, void *buffer) {
+	disk_read_multiple (d, sec_no, 1, buffer);
+}
+
+/* Write sector SEC_NO to disk D from BUFFER, which must contain
+   DISK_SECTOR_SIZE bytes.  Returns after the disk has
+   acknowledged receiving the data.
+   Internally synchronizes accesses to disks, so external
+   per-disk locking is unneeded. */
+void
+disk_write (struct disk *d, disk_sector_t sec_no, const void *buffer) {
+	disk_write_multiple (d, sec_no, 1, buffer);
+}
+
+/* Reads CNT consecutive sectors starting at SEC_NO from disk D
+   into BUFFER, which must have room for CNT * DISK_SECTOR_SIZE
+   bytes.  Up to 256 sectors go out as a single command, and the
+   device interrupts once per DRQ block of D->multiple sectors
+   rather than once per sector.
+   Internally synchronizes accesses to disks, so external
+   per-disk locking is unneeded. */
+void
+disk_read_multiple (struct disk *d, disk_sector_t sec_no, size_t cnt,
+		void *buffer) {
 	struct channel *c;
+	uint8_t *p = buffer;
+	int64_t start;
 
 	ASSERT (d != NULL);
 	ASSERT (buffer != NULL);
 
 	c = d->channel;
 	lock_acquire (&c->lock);
-	select_sector (d, sec_no);
-	issue_pio_command (c, CMD_READ_SECTOR_RETRY);
-	sema_down (&c->completion_wait);
-	if (!wait_while_busy (d))
-		PANIC ("%s: disk read failed, sector=%"PRDSNu, d->name, sec_no);
-	input_sector (c, buffer);
-	d->read_cnt++;
+	start = timer_now_ns ();
+	while (cnt > 0) {
+		size_t cmd_cnt = cnt < SECTORS_PER_CMD ? cnt : SECTORS_PER_CMD;
+		size_t done, blk, i;
+
+		select_sector (d, sec_no, cmd_cnt);
+		issue_pio_command (c, d->multiple > 1
+				? CMD_READ_MULTIPLE : CMD_READ_SECTOR_RETRY);
+		for (done = 0; done < cmd_cnt; done += blk) {
+			blk = cmd_cnt - done < (size_t) d->multiple
+				? cmd_cnt - done : (size_t) d->multiple;
+			sema_down (&c->completion_wait);
+			if (!wait_while_busy (d))
+				PANIC ("%s: disk read failed, sector=%"PRDSNu, d->name,
+						(disk_sector_t) (sec_no + done));
+			for (i = 0; i < blk; i++, p += DISK_SECTOR_SIZE)
+				input_sector (c, p);
+		}
+		d->read_cnt += cmd_cnt;
+		sec_no += cmd_cnt;
+		cnt -= cmd_cnt;
+	}
+	d->io_ns += timer_now_ns () - start;
 	lock_release (&c->lock);
 }
 
-/* Write sector SEC_NO to disk D from BUFFER, which must contain
-   DISK_SECTOR_SIZE bytes.  Returns after the disk has
-   acknowledged receiving the data.
+/* Writes CNT consecutive sectors starting at SEC_NO to disk D
+   from BUFFER, which must contain CNT * DISK_SECTOR_SIZE bytes.
+   Returns after the disk has acknowledged receiving the data.
+   Batches sectors into commands as disk_read_multiple() does.
    Internally synchronizes accesses to disks, so external
    per-disk locking is unneeded. */
 void
-disk_write (struct disk *d, disk_sector_t sec_no, const void *buffer) {
+disk_write_multiple (struct disk *d, disk_sector_t sec_no, size_t cnt,
+		const void *buffer) {
 	struct channel *c;
+	const uint8_t *p = buffer;
+	int64_t start;
 
 	ASSERT (d != NULL);
 	ASSERT (buffer != NULL);
 
 	c = d->channel;
 	lock_acquire (&c->lock);
-	select_sector (d, sec_no);
-	issue_pio_command (c, CMD_WRITE_SECTOR_RETRY);
-	if (!wait_while_busy (d))
-		PANIC ("%s: disk write failed, sector=%"PRDSNu, d->name, sec_no);
-	output_sector (c, buffer);
-	sema_down (&c->completion_wait);
-	d->write_cnt++;
+	start = timer_now_ns ();
+	while (cnt > 0) {
+		size_t cmd_cnt = cnt < SECTORS_PER_CMD ? cnt : SECTORS_PER_CMD;
+		size_t done, blk, i;
+
+		select_sector (d, sec_no, cmd_cnt);
+		issue_pio_command (c, d->multiple > 1
+				? CMD_WRITE_MULTIPLE : CMD_WRITE_SECTOR_RETRY);
+		/* The device asks for the first block through DRQ alone, and
+		   interrupts once it is ready for each following block and
+		   after the last one. */
+		for (done = 0; done < cmd_cnt; done += blk) {
+			blk = cmd_cnt - done < (size_t) d->multiple
+				? cmd_cnt - done : (size_t) d->multiple;
+			if (done > 0)
+				sema_down (&c->completion_wait);
+			if (!wait_while_busy (d))
+				PANIC ("%s: disk write failed, sector=%"PRDSNu, d->name,
+						(disk_sector_t) (sec_no + done));
+			for (i = 0; i < blk; i++, p += DISK_SECTOR_SIZE)
+				output_sector (c, p);
+		}
+		sema_down (&c->completion_wait);
+		d->write_cnt += cmd_cnt;
+		sec_no += cmd_cnt;
+		cnt -= cmd_cnt;
+	}
+	d->io_ns += timer_now_ns () - start;
 	lock_release (&c->lock);
 }
 
@@ -363,6 +452,7 @@ identify_ata_device (struct disk *d) {
 
 	/* Calculate capacity. */
 	d->capacity = id[60] | ((uint32_t) id[61] << 16);
+	set_multiple_mode (d, id);
 
 	/* Print identification message. */
 	printf ("%s: detected %'"PRDSNu" sector (", d->name, d->capacity);
@@ -379,7 +469,35 @@ identify_ata_device (struct disk *d) {
 	print_ata_string ((char *) &id[27], 40);
 	printf ("\", serial \"");
 	print_ata_string ((char *) &id[10], 20);
-	printf ("\"\n");
+	printf ("\"");
+	if (d->multiple > 1)
+		printf (", %d sectors per block", d->multiple);
+	printf ("\n");
+}
+
+/* Enables READ/WRITE MULTIPLE on disk D if its IDENTIFY DEVICE
+   data ID says it supports them.  Word 47 holds the largest
+   number of sectors the device moves per DRQ block; we ask for
+   the largest power of two up to that and MULTIPLE_MAX.  D keeps
+   single-sector blocks if the device rejects the request. */
+static void
+set_multiple_mode (struct disk *d, const uint16_t id[]) {
+	struct channel *c = d->channel;
+	int max = id[47] & 0xff;
+	int multiple = 1;
+
+	while (multiple * 2 <= max && multiple * 2 <= MULTIPLE_MAX)
+		multiple *= 2;
+	if (multiple == 1)
+		return;
+
+	select_device_wait (d);
+	outb (reg_nsect (c), multiple);
+	issue_pio_command (c, CMD_SET_MULTIPLE_MODE);
+	sema_down (&c->completion_wait);
+	wait_while_busy (d);
+	if (!(inb (reg_status (c)) & STA_ERR))
+		d->multiple = multiple;
 }
 
 /* Prints STRING, which consists of SIZE bytes in a funky format:
@@ -402,17 +520,19 @@ print_ata_string (char *string, size_t size) {
 }
 
 /* Selects device D, waiting for it to become ready, and then
-   writes SEC_NO to the disk's sector selection registers.  (We
-   use LBA mode.) */
+   writes SEC_NO and the count CNT, at most 256, of sectors to
+   transfer to the disk's sector selection registers.  (We use
+   LBA mode.) */
 static void
-select_sector (struct disk *d, disk_sector_t sec_no) {
+select_sector (struct disk *d, disk_sector_t sec_no, size_t cnt) {
 	struct channel *c = d->channel;
 
-	ASSERT (sec_no < d->capacity);
-	ASSERT (sec_no < (1UL << 28));
+	ASSERT (cnt > 0 && cnt <= SECTORS_PER_CMD);
+	ASSERT (sec_no + cnt <= d->capacity);
+	ASSERT (sec_no + cnt <= (1UL << 28));
 
 	select_device_wait (d);
-	outb (reg_nsect (c), 1);
+	outb (reg_nsect (c), cnt % SECTORS_PER_CMD);
 	outb (reg_lbal (c), sec_no);
 	outb (reg_lbam (c), sec_no >> 8);
 	outb (reg_lbah (c), (sec_no >> 16));
@@ -520,7 +640,8 @@ interrupt_handler (struct intr_frame *f) {
 		if (f->vec_no == c->irq) {
 			if (c->expecting_interrupt) {
 				inb (reg_status (c));               /* Acknowledge interrupt. */
-				sema_up (&c->completion_wait);      /* Wake up waiter. */
+				c->completed = true;                /* Wake waiter in bottom half. */
+				raise_softirq (SOFTIRQ_DISK);
 			} else
 				printf ("%s: unexpected interrupt\n", c->name);
 			return;
@@ -529,6 +650,22 @@ interrupt_handler (struct intr_frame *f) {
 	NOT_REACHED ();
 }
 
+/* ATA bottom half: wakes the threads whose requests completed. */
+static void
+disk_softirq (void) {
+	struct channel *c;
+
+	for (c = channels; c < channels + CHANNEL_CNT; c++) {
+		enum intr_level old_level = intr_disable ();
+		bool completed = c->completed;
+		c->completed = false;
+		intr_set_level (old_level);
+
+		if (completed)
+			sema_up (&c->completion_wait);
+	}
+}
+
 static void
 inspect_read_cnt (struct intr_frame *f) {
 	struct disk * d = disk_get (f->R.rdx, f->R.rcx);
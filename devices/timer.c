@@ -1,12 +1,15 @@
 #include "devices/timer.h"
 #include <debug.h>
 #include <inttypes.h>
+#include <intrinsic.h>
 #include <round.h>
 #include <stdio.h>
 #include "threads/interrupt.h"
 #include "threads/io.h"
+#include "threads/profile.h"
 #include "threads/synch.h"
 #include "threads/thread.h"
+#include "threads/workqueue.h"
 
 /* See [8254] for hardware details of the 8254 timer chip. */
 
@@ -24,31 +27,72 @@ static int64_t ticks;
    Initialized by timer_calibrate(). */
 static unsigned loops_per_tick;
 
+/* 8254 input frequency and the counter value for one timer tick. */
+#define PIT_FREQ 1193180
+#define PIT_COUNT_PER_TICK ((PIT_FREQ + TIMER_FREQ / 2) / TIMER_FREQ)
+
+/* tickless idle (-nohz) 관련
+   - idle thread만 남아 있을 때, 다음으로 깨워야 할 시점까지 PIT를 one-shot으로 설정해
+     그 사이의 timer interrupt를 건너뜀
+   - PIT counter가 16bit이므로 한 번에 건너뛸 수 있는 tick 수는 NOHZ_MAX_TICKS로 제한됨 */
+#define NOHZ_MAX_TICKS (0xffff / PIT_COUNT_PER_TICK)
+bool timer_nohz;
+static int64_t oneshot_ticks;   /* one-shot으로 설정한 tick 수, 0이면 periodic 상태. */
+
+/* TSC clocksource 관련
+   - timer_calibrate()에서 TSC_CALIBRATE_TICKS개의 tick 동안 증가한 TSC로
+     cycle 당 ns를 구해 2^TSC_SHIFT배 한 값을 tsc_mult에 저장
+   - 보정 전(tsc_mult == 0)에는 tick 단위로만 시간을 알 수 있음 */
+#define NSEC_PER_SEC 1000000000LL
+#define TICK_NS ((int64_t) PIT_COUNT_PER_TICK * NSEC_PER_SEC / PIT_FREQ)
+#define TSC_SHIFT 24
+#define TSC_CALIBRATE_TICKS 10
+static uint64_t tsc_mult;       /* (ns / cycle) << TSC_SHIFT. */
+static uint64_t tsc_base;       /* 보정을 마친 시점의 TSC. */
+static int64_t ns_base;         /* 보정을 마친 시점의 timer_now_ns(). */
+
+/* hrtimer 관련
+   - 다음 tick 전에 만료되는 hrtimer가 있으면 PIT를 그 시각에 울리도록 one-shot으로
+     설정하고, 울린 뒤에는 원래 tick 시각까지 남은 시간으로 다시 one-shot을 설정함
+   - tick 시각에 HRTIMER_SLACK_NS 이내로 가까운 hrtimer는 그 tick에서 함께 처리 */
+#define HRTIMER_SLACK_NS 20000
+static struct rb_tree hrtimers;  /* 만료 시각 순으로 정렬된 active hrtimer들. */
+static bool hrtimer_oneshot;    /* PIT가 tick 사이의 one-shot으로 설정되어 있는지 여부. */
+static int64_t next_tick_ns;    /* 다음 tick이 울릴 시각. */
+
 static intr_handler_func timer_interrupt;
+static softirq_func timer_softirq;
 static bool too_many_loops (unsigned loops);
 static void busy_wait (int64_t loops);
 static void real_time_sleep (int64_t num, int32_t denom);
+static void pit_set_periodic (void);
+static void pit_set_oneshot (uint16_t count);
+static uint16_t pit_read_count (void);
+static void pit_set_oneshot_ns (int64_t ns);
+static bool hrtimer_less (const struct rb_elem *, const struct rb_elem *,
+		void *);
+static void hrtimer_program (int64_t now);
+static void hrtimer_run (void);
 
 /* Sets up the 8254 Programmable Interval Timer (PIT) to
    interrupt PIT_FREQ times per second, and registers the
    corresponding interrupt. */
 void
 timer_init (void) {
-	/* 8254 input frequency divided by TIMER_FREQ, rounded to
-	   nearest. */
-	uint16_t count = (1193180 + TIMER_FREQ / 2) / TIMER_FREQ;
-
-	outb (0x43, 0x34);    /* CW: counter 0, LSB then MSB, mode 2, binary. */
-	outb (0x40, count & 0xff);
-	outb (0x40, count >> 8);
+	rb_init (&hrtimers, hrtimer_less, NULL);
+	pit_set_periodic ();
 
 	intr_register_ext (0x20, timer_interrupt, "8254 Timer");
+	softirq_register (SOFTIRQ_TIMER, timer_softirq);
 }
 
-/* Calibrates loops_per_tick, used to implement brief delays. */
+/* Calibrates loops_per_tick, used to implement brief delays, and
+   the TSC clocksource behind timer_now_ns(). */
 void
 timer_calibrate (void) {
 	unsigned high_bit, test_bit;
+	uint64_t tsc_start, tsc_end;
+	int64_t start;
 
 	ASSERT (intr_get_level () == INTR_ON);
 	printf ("Calibrating timer...  ");
@@ -67,7 +111,27 @@ timer_calibrate (void) {
 		if (!too_many_loops (high_bit | test_bit))
 			loops_per_tick |= test_bit;
 
-	printf ("%'"PRIu64" loops/s.\n", (uint64_t) loops_per_tick * TIMER_FREQ);
+	/* Count TSC cycles over TSC_CALIBRATE_TICKS ticks, starting
+	   right at a tick boundary. */
+	start = ticks;
+	while (ticks == start)
+		barrier ();
+	tsc_start = rdtsc ();
+	start = ticks;
+	while (ticks - start < TSC_CALIBRATE_TICKS)
+		barrier ();
+	tsc_end = rdtsc ();
+
+	enum intr_level old_level = intr_disable ();
+	tsc_base = tsc_end;
+	ns_base = ticks * TICK_NS;
+	tsc_mult = ((uint64_t) TSC_CALIBRATE_TICKS * TICK_NS << TSC_SHIFT)
+		/ (tsc_end - tsc_start);
+	intr_set_level (old_level);
+
+	printf ("%'"PRIu64" loops/s, %'"PRIu64" TSC cycles/s.\n",
+			(uint64_t) loops_per_tick * TIMER_FREQ,
+			(tsc_end - tsc_start) * TIMER_FREQ / TSC_CALIBRATE_TICKS);
 }
 
 /* Returns the number of timer ticks since the OS booted. */
@@ -91,6 +155,22 @@ timer_elapsed (int64_t then) {
 	return timer_ticks () - then;
 }
 
+/* Returns the number of nanoseconds since the OS booted.  Reads
+   the TSC once timer_calibrate() has run, and has only timer
+   tick resolution before that.  Safe to call from any context. */
+int64_t
+timer_now_ns (void) {
+	uint64_t delta;
+
+	if (tsc_mult == 0)
+		return timer_ticks () * TICK_NS;
+
+	// delta * tsc_mult가 넘치지 않도록 상위/하위 TSC_SHIFT bit를 나눠서 곱함
+	delta = rdtsc () - tsc_base;
+	return ns_base + (int64_t) ((delta >> TSC_SHIFT) * tsc_mult
+			+ (((delta & ((1ULL << TSC_SHIFT) - 1)) * tsc_mult) >> TSC_SHIFT));
+}
+
 /* Suspends execution for approximately TICKS timer ticks. */
 void
 timer_sleep (int64_t ticks) {
@@ -131,18 +211,295 @@ timer_nsleep (int64_t ns) {
 /* Prints timer statistics. */
 void
 timer_print_stats (void) {
-	printf ("Timer: %"PRId64" ticks\n", timer_ticks ());
+	printf ("Timer: %"PRId64" ticks, %"PRId64" ns\n",
+			timer_ticks (), timer_now_ns ());
+}
+
+/* Initializes TIMER to call FUNC when it expires.  FUNC runs in
+   the timer bottom half with interrupts off, so it must not
+   sleep. */
+void
+hrtimer_init (struct hrtimer *timer, hrtimer_func *func) {
+	ASSERT (timer != NULL);
+	ASSERT (func != NULL);
+
+	timer->expires = 0;
+	timer->func = func;
+	timer->active = false;
+}
+
+/* Arms TIMER to expire at EXPIRES, in timer_now_ns() units,
+   re-arming it if it is already active.  If EXPIRES falls before
+   the next timer tick, the PIT is switched to one-shot mode to
+   interrupt right at EXPIRES.  Requires timer_calibrate() to
+   have run.  May be called from an interrupt handler. */
+void
+hrtimer_start (struct hrtimer *timer, int64_t expires) {
+	enum intr_level old_level;
+
+	ASSERT (timer != NULL);
+	ASSERT (tsc_mult != 0);
+
+	old_level = intr_disable ();
+	if (timer->active)
+		rb_remove (&hrtimers, &timer->elem);
+	timer->expires = expires;
+	timer->active = true;
+	rb_insert (&hrtimers, &timer->elem);
+
+	// tickless idle 중이었다면 periodic tick으로 되돌린 뒤 one-shot을 다시 잡음
+	timer_idle_exit ();
+	hrtimer_program (timer_now_ns ());
+	intr_set_level (old_level);
+}
+
+/* Disarms TIMER.  Returns true if it was active, false if it had
+   already expired or was never started. */
+bool
+hrtimer_cancel (struct hrtimer *timer) {
+	enum intr_level old_level;
+	bool was_active;
+
+	ASSERT (timer != NULL);
+
+	old_level = intr_disable ();
+	was_active = timer->active;
+	if (was_active) {
+		rb_remove (&hrtimers, &timer->elem);
+		timer->active = false;
+	}
+	intr_set_level (old_level);
+	return was_active;
 }
 
+/* Called by the idle thread, with interrupts off, right before it
+   halts the CPU.  If tickless idle is enabled, stops the periodic
+   tick and programs the PIT to fire once at the next sleeper's
+   wake-up tick, or after NOHZ_MAX_TICKS if that is sooner. */
+void
+timer_idle_enter (void) {
+	int64_t delta;
+
+	ASSERT (intr_get_level () == INTR_OFF);
+	if (!timer_nohz || oneshot_ticks != 0 || hrtimer_oneshot)
+		return;
+
+	// 다음으로 깨워야 할 thread 또는 delayed work까지 남은 tick 수 (둘 다 없으면 INT64_MAX)
+	delta = get_next_tick_to_awake () - ticks;
+	if (workqueue_next_tick () - ticks < delta)
+		delta = workqueue_next_tick () - ticks;
+	// 가장 빠른 hrtimer보다 먼저 깨어나, 그 직전 tick에서 one-shot을 설정하도록 함
+	if (!rb_empty (&hrtimers)) {
+		int64_t expires = rb_entry (rb_min (&hrtimers), struct hrtimer, elem)->expires;
+		if ((expires - timer_now_ns ()) / TICK_NS < delta)
+			delta = (expires - timer_now_ns ()) / TICK_NS;
+	}
+	if (delta > NOHZ_MAX_TICKS)
+		delta = NOHZ_MAX_TICKS;
+	// MLFQS는 매 초 load_avg를 갱신해야 하므로 초 경계를 건너뛰지 않음
+	if (thread_mlfqs && delta > TIMER_FREQ - ticks % TIMER_FREQ)
+		delta = TIMER_FREQ - ticks % TIMER_FREQ;
+	// 바로 다음 tick에 깨워야 한다면 periodic tick을 그대로 사용
+	if (delta <= 1)
+		return;
+
+	oneshot_ticks = delta;
+	pit_set_oneshot (delta * PIT_COUNT_PER_TICK);
+}
+
+/* Called with interrupts off when the CPU leaves tickless idle:
+   by the idle thread after it wakes up from halt, and by the
+   scheduler when it switches from the idle thread to a thread
+   that an interrupt woke up.  If the one-shot timer has not been
+   handled yet, that is, another interrupt woke the CPU, adds the
+   ticks that have passed in the meantime and restarts the
+   periodic tick. */
+void
+timer_idle_exit (void) {
+	int64_t programmed = oneshot_ticks * PIT_COUNT_PER_TICK;
+	int64_t count, elapsed;
+
+	ASSERT (intr_get_level () == INTR_OFF);
+	if (oneshot_ticks == 0)
+		return;
+
+	count = pit_read_count ();
+	if (count == 0 || count > programmed) {
+		// one-shot이 이미 만료됨: mode 0 counter는 0을 지나 wrap 되므로 설정값보다 커질 수 있음
+		// - 아직 처리되지 않은 timer interrupt가 마지막 tick을 더하므로 그 하나를 빼고 반영
+		elapsed = oneshot_ticks - 1;
+	} else {
+		// one-shot을 설정한 뒤 지나간 tick 수 (마지막 tick 미만의 자투리는 버림)
+		elapsed = (programmed - count) / PIT_COUNT_PER_TICK;
+	}
+	// ticks가 뒤로 가거나 설정한 것보다 많이 건너뛰지 않도록 [0, oneshot_ticks]로 제한
+	if (elapsed < 0)
+		elapsed = 0;
+	else if (elapsed > oneshot_ticks)
+		elapsed = oneshot_ticks;
+	oneshot_ticks = 0;
+	pit_set_periodic ();
+
+	ticks += elapsed;
+	thread_add_idle_ticks (elapsed);
+}
+
 /* Timer interrupt handler. */
 static void
 timer_interrupt (struct intr_frame *args UNUSED) {
+	// tick 사이에 hrtimer를 위해 설정한 one-shot이 울린 경우
+	if (hrtimer_oneshot) {
+		int64_t now = timer_now_ns ();
+		if (now < next_tick_ns - HRTIMER_SLACK_NS) {
+			// 아직 tick 시각이 아니므로 tick까지 남은 시간으로 다시 one-shot을 설정
+			pit_set_oneshot_ns (next_tick_ns - now);
+			hrtimer_program (now);
+			return;
+		}
+		hrtimer_oneshot = false;
+		pit_set_periodic ();
+	}
+	// one-shot으로 건너뛴 tick들을 몰아서 반영 (마지막 tick은 아래에서 처리)
+	if (oneshot_ticks != 0) {
+		ticks += oneshot_ticks - 1;
+		thread_add_idle_ticks (oneshot_ticks - 1);
+		oneshot_ticks = 0;
+		pit_set_periodic ();
+	}
 	ticks++;
+	next_tick_ns = timer_now_ns () + TICK_NS;
 	thread_tick ();
-	// 매 tick 마다 sleep_list에서 깨울 thread가 있는지 확인
-	if (get_next_tick_to_awake() <= ticks) {
-		thread_awake(ticks);
+#ifdef CPU_PROFILE
+	profile_sample (args);
+#endif
+	// 깨울 thread나 만료된 delayed work가 있다면 나머지는 bottom half에서 처리
+	if (get_next_tick_to_awake () <= ticks || workqueue_next_tick () <= ticks)
+		raise_softirq (SOFTIRQ_TIMER);
+	hrtimer_program (timer_now_ns ());
+}
+
+/* Timer bottom half, run with interrupts on.  Wakes sleeping
+   threads a batch at a time, letting interrupts in between
+   batches, queues expired delayed work and runs expired
+   hrtimers. */
+static void
+timer_softirq (void) {
+	enum intr_level old_level;
+	int64_t now = timer_ticks ();
+	bool more = true;
+
+	while (more) {
+		old_level = intr_disable ();
+		more = get_next_tick_to_awake () <= now;
+		if (more)
+			thread_awake (now);
+		intr_set_level (old_level);
 	}
+
+	old_level = intr_disable ();
+	workqueue_tick (now);
+	hrtimer_run ();
+	intr_set_level (old_level);
+}
+
+/* Sets up the PIT to interrupt TIMER_FREQ times per second. */
+static void
+pit_set_periodic (void) {
+	/* 8254 input frequency divided by TIMER_FREQ, rounded to
+	   nearest. */
+	uint16_t count = PIT_COUNT_PER_TICK;
+
+	outb (0x43, 0x34);    /* CW: counter 0, LSB then MSB, mode 2, binary. */
+	outb (0x40, count & 0xff);
+	outb (0x40, count >> 8);
+	next_tick_ns = timer_now_ns () + TICK_NS;
+}
+
+/* Sets up the PIT to interrupt once, after COUNT input clocks. */
+static void
+pit_set_oneshot (uint16_t count) {
+	outb (0x43, 0x30);    /* CW: counter 0, LSB then MSB, mode 0, binary. */
+	outb (0x40, count & 0xff);
+	outb (0x40, count >> 8);
+}
+
+/* Sets up the PIT to interrupt once, after NS nanoseconds, which
+   must be at most one timer tick. */
+static void
+pit_set_oneshot_ns (int64_t ns) {
+	int64_t count = ns * PIT_FREQ / NSEC_PER_SEC;
+
+	if (count < 1)
+		count = 1;
+	if (count > 0xffff)
+		count = 0xffff;
+	pit_set_oneshot (count);
+}
+
+/* Orders hrtimers by expiry time, earliest first. */
+static bool
+hrtimer_less (const struct rb_elem *a_, const struct rb_elem *b_,
+		void *aux UNUSED) {
+	const struct hrtimer *a = rb_entry (a_, struct hrtimer, elem);
+	const struct hrtimer *b = rb_entry (b_, struct hrtimer, elem);
+
+	return a->expires < b->expires;
+}
+
+/* Makes sure the earliest hrtimer fires on time, given that the
+   time is NOW.  If it has already expired, raises the timer
+   softirq (from interrupt context) or fires the PIT right away.
+   If it expires before the next tick, programs the PIT to
+   interrupt at its expiry.  Otherwise the periodic tick will get
+   to it. */
+static void
+hrtimer_program (int64_t now) {
+	struct hrtimer *t;
+
+	ASSERT (intr_get_level () == INTR_OFF);
+	if (rb_empty (&hrtimers) || oneshot_ticks != 0)
+		return;
+
+	t = rb_entry (rb_min (&hrtimers), struct hrtimer, elem);
+	// 이미 만료되었다면 bottom half에서 처리 (bottom half 끝에서 다시 호출됨)
+	if (t->expires <= now && intr_context ()) {
+		raise_softirq (SOFTIRQ_TIMER);
+		return;
+	}
+	if (t->expires >= next_tick_ns - HRTIMER_SLACK_NS)
+		return;
+
+	pit_set_oneshot_ns (t->expires - now);
+	hrtimer_oneshot = true;
+}
+
+/* Removes expired hrtimers and calls their functions, then
+   programs the PIT for the next one. */
+static void
+hrtimer_run (void) {
+	int64_t now = timer_now_ns ();
+
+	ASSERT (intr_get_level () == INTR_OFF);
+	while (!rb_empty (&hrtimers)) {
+		struct hrtimer *t = rb_entry (rb_min (&hrtimers), struct hrtimer, elem);
+		if (t->expires > now)
+			break;
+		rb_remove (&hrtimers, &t->elem);
+		t->active = false;
+		t->func (t);
+	}
+	hrtimer_program (timer_now_ns ());
+}
+
+/* Returns the current value of the PIT's counter 0. */
+static uint16_t
+pit_read_count (void) {
+	uint8_t lo, hi;
+
+	outb (0x43, 0x00);    /* CW: latch counter 0. */
+	lo = inb (0x40);
+	hi = inb (0x40);
+	return lo | (hi << 8);
 }
 
 /* Returns true if LOOPS iterations waits for more than one timer
@@ -176,6 +533,34 @@ busy_wait (int64_t loops) {
 		barrier ();
 }
 
+/* A thread blocked in hrtimer_sleep(). */
+struct hrtimer_sleeper {
+	struct hrtimer timer;
+	struct semaphore done;      /* Up'd when TIMER expires. */
+};
+
+/* hrtimer function for hrtimer_sleep(): wakes the sleeper. */
+static void
+hrtimer_wakeup (struct hrtimer *timer) {
+	struct hrtimer_sleeper *s = (struct hrtimer_sleeper *) timer;
+
+	sema_up (&s->done);
+	// 깨어난 thread가 더 높은 priority일 수 있으므로 반환 시 양보
+	intr_yield_on_return ();
+}
+
+/* Blocks the current thread until timer_now_ns() reaches
+   EXPIRES. */
+static void
+hrtimer_sleep (int64_t expires) {
+	struct hrtimer_sleeper s;
+
+	hrtimer_init (&s.timer, hrtimer_wakeup);
+	sema_init (&s.done, 0);
+	hrtimer_start (&s.timer, expires);
+	sema_down (&s.done);
+}
+
 /* Sleep for approximately NUM/DENOM seconds. */
 static void
 real_time_sleep (int64_t num, int32_t denom) {
@@ -188,7 +573,14 @@ real_time_sleep (int64_t num, int32_t denom) {
 	int64_t ticks = num * TIMER_FREQ / denom;
 
 	ASSERT (intr_get_level () == INTR_ON);
-	if (ticks > 0) {
+	ASSERT (NSEC_PER_SEC % denom == 0);
+	if (tsc_mult != 0) {
+		/* Once the TSC is calibrated, block on an hrtimer, which
+		   wakes us up within microseconds of the deadline even
+		   for sub-tick sleeps. */
+		if (num > 0)
+			hrtimer_sleep (timer_now_ns () + num * (NSEC_PER_SEC / denom));
+	} else if (ticks > 0) {
 		/* We're waiting for at least one full timer tick.  Use
 		   timer_sleep() because it will yield the CPU to other
 		   processes. */
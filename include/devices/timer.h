@@ -1,7 +1,9 @@
 #ifndef DEVICES_TIMER_H
 #define DEVICES_TIMER_H
 
+#include <rbtree.h>
 #include <round.h>
+#include <stdbool.h>
 #include <stdint.h>
 
 /* Number of timer interrupts per second. */
@@ -12,6 +14,7 @@ void timer_calibrate (void);
 
 int64_t timer_ticks (void);
 int64_t timer_elapsed (int64_t);
+int64_t timer_now_ns (void);
 
 void timer_sleep (int64_t ticks);
 void timer_msleep (int64_t milliseconds);
@@ -20,4 +23,26 @@ void timer_nsleep (int64_t nanoseconds);
 
 void timer_print_stats (void);
 
+/* High-resolution timer, expiring at a timer_now_ns() time. */
+struct hrtimer;
+typedef void hrtimer_func (struct hrtimer *);
+
+struct hrtimer {
+	struct rb_elem elem;        /* Element in the hrtimer tree. */
+	int64_t expires;            /* Expiry time, in nanoseconds. */
+	hrtimer_func *func;         /* Called in the timer bottom half. */
+	bool active;                /* Armed and not yet expired? */
+};
+
+void hrtimer_init (struct hrtimer *, hrtimer_func *);
+void hrtimer_start (struct hrtimer *, int64_t expires);
+bool hrtimer_cancel (struct hrtimer *);
+
+/* If true, stop the periodic tick while the CPU is idle.
+   Controlled by kernel command-line option "-nohz". */
+extern bool timer_nohz;
+
+void timer_idle_enter (void);
+void timer_idle_exit (void);
+
 #endif /* devices/timer.h */
@@ -72,7 +72,24 @@ void intr_register_int (uint8_t vec, int dpl, enum intr_level,
 bool intr_context (void);
 void intr_yield_on_return (void);
 
+/* Softirqs: bottom halves of external interrupts. */
+enum softirq {
+	SOFTIRQ_TIMER,              /* Wake sleepers, delayed work, hrtimers. */
+	SOFTIRQ_DISK,               /* Complete disk requests. */
+	SOFTIRQ_CNT
+};
+
+typedef void softirq_func (void);
+
+void softirq_register (enum softirq, softirq_func *);
+void raise_softirq (enum softirq);
+
 void intr_dump_frame (const struct intr_frame *);
 const char *intr_name (uint8_t vec);
+#ifdef INTR_PROFILE
+void intr_print_stats (void);
+void intr_reset_stats (void);
+uint64_t intr_off_max_cycles (void);
+#endif
 
 #endif /* threads/interrupt.h */
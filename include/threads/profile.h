@@ -0,0 +1,19 @@
+#ifndef THREADS_PROFILE_H
+#define THREADS_PROFILE_H
+
+#ifdef CPU_PROFILE
+#include "threads/interrupt.h"
+
+/* Max number of stack frames recorded per sample. */
+#define PROFILE_DEPTH_MAX 8
+
+/* Number of stack frames to record per sample, 1 for a flat
+   profile.  Controlled by kernel command-line option
+   "-profile-depth=N". */
+extern int profile_depth;
+
+void profile_sample (const struct intr_frame *);
+void profile_print_stats (void);
+#endif /* CPU_PROFILE */
+
+#endif /* threads/profile.h */
@@ -0,0 +1,29 @@
+#ifndef THREADS_SWITCH_H
+#define THREADS_SWITCH_H
+
+#include <stdint.h>
+
+/* Switches from the current kernel thread to another one.
+
+   Pushes the callee-saved registers on the current stack, stores
+   the resulting stack pointer in *CUR_RSP, then loads NEXT_RSP,
+   pops the callee-saved registers that were pushed there and
+   returns into the other thread.  Interrupts must be off. */
+void switch_threads (uint64_t *cur_rsp, uint64_t next_rsp);
+
+/* Stack frame that switch_threads() pops, lowest address first. */
+struct switch_threads_frame {
+	uint64_t r15;
+	uint64_t r14;
+	uint64_t r13;
+	uint64_t r12;
+	uint64_t rbx;
+	uint64_t rbp;
+	void (*rip) (void);         /* Return address. */
+};
+
+/* First code run by a new thread: calls the function in rbx
+   with r12 and r13 as its arguments. */
+void switch_entry (void);
+
+#endif /* threads/switch.h */
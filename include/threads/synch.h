@@ -2,7 +2,10 @@
 #define THREADS_SYNCH_H
 
 #include <list.h>
+#include <rbtree.h>
 #include <stdbool.h>
+#include <stdint.h>
+#include "threads/interrupt.h"
 
 /* A counting semaphore. */
 struct semaphore {
@@ -15,11 +18,22 @@ void sema_down (struct semaphore *);
 bool sema_try_down (struct semaphore *);
 void sema_up (struct semaphore *);
 void sema_self_test (void);
-bool sema_compare_priority(const struct list_elem*, const struct list_elem *, void *);
 /* Lock. */
 struct lock {
 	struct thread *holder;      /* Thread holding lock (for debugging). */
 	struct semaphore semaphore; /* Binary semaphore controlling access. */
+
+	/* Priority donation. */
+	struct rb_tree donors;      /* Waiting threads, highest priority first. */
+	int priority;               /* Highest priority among DONORS. */
+	int64_t tickets;            /* Tickets lent by DONORS (-stride). */
+	struct rb_elem held_elem;   /* Element in holder's held_locks. */
+
+#ifdef LOCK_PROFILE
+	/* Profiling. */
+	struct lock_prof_site *prof_site; /* Call site that acquired it. */
+	uint64_t prof_acquired;     /* TSC value when acquired. */
+#endif
 };
 
 void lock_init (struct lock *);
@@ -27,10 +41,52 @@ void lock_acquire (struct lock *);
 bool lock_try_acquire (struct lock *);
 void lock_release (struct lock *);
 bool lock_held_by_current_thread (const struct lock *);
+#ifdef LOCK_PROFILE
+void lock_print_stats (void);
+#endif
+
+/* Adaptive mutex, for short critical sections.
+   A contended acquire first spins for up to MUTEX_SPIN_MAX
+   iterations while the holder is running on another CPU, on the
+   bet that it releases soon, and only then sleeps on the
+   underlying lock.  With a single CPU the holder can never be
+   running while we are, so the spin ends at once.
+
+   When built with LOCK_PROFILE, each mutex keeps hold-time and
+   contention statistics, which mutex_print_stats() reports and the
+   kernel prints at shutdown.  A mutex is registered for this when
+   initialized, so it must never be freed. */
+struct mutex {
+	struct lock lock;           /* Sleeping lock underneath. */
+
+#ifdef LOCK_PROFILE
+	char name[16];              /* Name (for statistics). */
+	struct mutex *next;         /* Next in list of all mutexes. */
+	uint64_t acquired_tsc;      /* TSC value when last acquired. */
+
+	/* Statistics. */
+	long long acquires;         /* # of acquisitions. */
+	long long contended;        /* # of acquisitions that found it held. */
+	long long spin_acquires;    /* # of contended acquisitions won by spinning. */
+	uint64_t hold_cycles;       /* Total TSC cycles held. */
+	uint64_t max_hold_cycles;   /* Longest hold, in TSC cycles. */
+#endif
+};
+
+#define MUTEX_SPIN_MAX 1000     /* Max spins before sleeping. */
+
+void mutex_init (struct mutex *, const char *name);
+void mutex_acquire (struct mutex *);
+bool mutex_try_acquire (struct mutex *);
+void mutex_release (struct mutex *);
+bool mutex_held_by_current_thread (const struct mutex *);
+#ifdef LOCK_PROFILE
+void mutex_print_stats (void);
+#endif
 
 /* Condition variable. */
 struct condition {
-	struct list waiters;        /* List of waiting threads. */
+	struct rb_tree waiters;     /* Waiting threads, highest priority first. */
 };
 
 void cond_init (struct condition *);
@@ -38,6 +94,63 @@ void cond_wait (struct condition *, struct lock *);
 void cond_signal (struct condition *, struct lock *);
 void cond_broadcast (struct condition *, struct lock *);
 
+/* Reader-writer lock.
+   Any number of readers, or a single writer, may hold it.  Once a
+   writer is waiting, new readers queue up behind it, so a steady
+   stream of readers cannot starve writers. */
+struct rwlock {
+	struct lock lock;           /* Held by the writer, and by readers entering. */
+	unsigned readers;           /* # of threads holding a read lock. */
+	unsigned writers;           /* # of threads holding or waiting to write. */
+	struct list read_holds;     /* Readers' `struct rwlock_hold's. */
+	struct thread *drainer;     /* Writer waiting for readers to leave, or null. */
+	struct semaphore drain;     /* Upped when the last reader leaves. */
+};
+
+/* One thread's read hold on a rwlock, used to donate a waiting
+   writer's priority to the readers.  The caller of
+   rwlock_read_acquire() provides it, usually on its own stack,
+   and must keep it alive until it releases the read lock, so a
+   thread can hold any number of read locks at once. */
+struct rwlock_hold {
+	struct rwlock *rwlock;      /* Read-held rwlock. */
+	struct thread *holder;      /* Thread holding it for reading. */
+	struct list_elem elem;      /* Element in rwlock's read_holds. */
+	struct list_elem thread_elem; /* Element in holder's read_holds. */
+};
+
+void rwlock_init (struct rwlock *);
+void rwlock_read_acquire (struct rwlock *, struct rwlock_hold *);
+bool rwlock_read_try_acquire (struct rwlock *, struct rwlock_hold *);
+void rwlock_read_release (struct rwlock *);
+void rwlock_write_acquire (struct rwlock *);
+bool rwlock_write_try_acquire (struct rwlock *);
+void rwlock_write_release (struct rwlock *);
+bool rwlock_upgrade (struct rwlock *);
+void rwlock_downgrade (struct rwlock *, struct rwlock_hold *);
+bool rwlock_read_held_by_current_thread (const struct rwlock *);
+bool rwlock_write_held_by_current_thread (const struct rwlock *);
+
+/* Spinlock.
+   Protects short critical sections that must not sleep.  The
+   holder runs with interrupts disabled, so a spinlock may also be
+   shared with interrupt handlers.
+
+   The kernel runs on a single CPU: there is no LAPIC setup or AP
+   startup, and the rest of the kernel still relies on
+   intr_disable() for mutual exclusion.  On one CPU the lock word
+   is never contended, so a spinlock costs about as much as
+   disabling interrupts. */
+struct spinlock {
+	volatile unsigned locked;   /* Nonzero while held. */
+	struct thread *holder;      /* Thread holding lock (for debugging). */
+};
+
+void spin_lock_init (struct spinlock *);
+enum intr_level spin_lock_irqsave (struct spinlock *);
+void spin_unlock_irqrestore (struct spinlock *, enum intr_level);
+bool spin_lock_held_by_current_thread (const struct spinlock *);
+
 /* Optimization barrier.
  *
  * The compiler will not reorder operations across an
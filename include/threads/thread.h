@@ -3,9 +3,11 @@
 
 #include <debug.h>
 #include <list.h>
+#include <rbtree.h>
 #include <stdint.h>
 #include "threads/interrupt.h"
 #include "threads/synch.h"
+#include "threads/fixed-point.h"
 #ifdef VM
 #include "vm/vm.h"
 #endif
@@ -30,12 +32,24 @@ typedef int tid_t;
 #define PRI_DEFAULT 31                  /* Default priority. */
 #define PRI_MAX 63                      /* Highest priority. */
 
+/* Thread niceness (MLFQS). */
+#define NICE_MIN -20                    /* Nicest. */
+#define NICE_DEFAULT 0                  /* Default niceness. */
+#define NICE_MAX 20                     /* Least nice. */
+
+/* Thread tickets (stride scheduler). */
+#define STRIDE_TICKETS_MIN 1            /* Smallest share. */
+#define STRIDE_TICKETS_DEFAULT 100      /* Default share. */
+#define STRIDE_TICKETS_MAX 10000        /* Largest share. */
+
 /* file descriptor related */
 // #define FDT_ENTRY_MAX 64
 // #define FDT_PAGE_CNT (FDT_ENTRY_MAX + (PGSIZE - 1)) / (PGSIZE)
 
 #define FDT_PAGE_CNT 3				
 #define FDT_ENTRY_MAX FDT_PAGE_CNT *(1 << 9)    
+#define FDT_STDIN ((struct file *) 10)		/* fd 0이 열려 있음을 나타내는 dummy 값 */
+#define FDT_STDOUT ((struct file *) 11)		/* fd 1이 열려 있음을 나타내는 dummy 값 */
 
 /* A kernel thread or user process.
  *
@@ -107,10 +121,51 @@ struct thread {
 
 	/* donation 관련 멤버 */
 	int init_priority; 					/* (donate 받는 입장에서) donate 받기 전 최초의 priority를 기록 */
+	int read_boost;						/* (donate 받는 입장에서) read lock을 가진 rwlock에서 기다리는 writer의 최고 priority */
 
 	struct lock *wait_on_lock;          /* (donate 주는 입장에서) donate 주는 이유인 lock을 기록 */
-	struct list donations;				/* (donate 받는 입장에서) 본인에게 donate 준 thread 들을 기록 */
-	struct list_elem donation_elem;		/* (donate 주는 입장에서) donate 받은 thread의 donation list에서 연결 노드로 사용됨 */
+	struct rb_tree held_locks;			/* (donate 받는 입장에서) 가진 lock들을 각 lock이 받은 donation 순으로 기록 */
+	/* lock을 기다리는 동안과 condition variable을 기다리는 동안은 겹치지 않으므로 노드를 공유
+	  - cond_wait은 signal을 받아 waiters에서 빠진 뒤에야 lock을 다시 기다림 */
+	union {
+		struct rb_elem donor_elem;		/* (donate 주는 입장에서) wait_on_lock의 donors에서 연결 노드로 사용됨 */
+		struct rb_elem cond_elem;		/* wait_on_cond의 waiters에서 연결 노드로 사용됨 */
+	};
+	struct rwlock *drain_rwlock;		/* (donate 주는 입장에서) reader들이 빠져나가기를 기다리는 rwlock */
+	struct list read_holds;				/* 가지고 있는 read lock들의 struct rwlock_hold */
+	struct condition *wait_on_cond;		/* 기다리는 condition variable (없으면 NULL) */
+
+	/* MLFQS 관련 멤버 */
+	int nice;							/* 다른 thread에게 CPU를 양보하는 정도 (NICE_MIN ~ NICE_MAX) */
+	fixed_t recent_cpu;					/* 최근에 CPU를 사용한 정도 (17.14 fixed-point) */
+	struct list_elem all_elem;			/* all_list에 연결되는 노드 (매 초 recent_cpu 재계산에 사용) */
+
+	/* fair/stride scheduler 관련 멤버: 한 번의 boot에서는 둘 중 하나만 사용하므로 공간을 공유 */
+	union {
+		int64_t vruntime;				/* (fair) weight로 나눈 누적 실행 시간 (작을수록 먼저 실행됨) */
+		int64_t pass;					/* (stride) tickets로 나눈 누적 실행 시간 (작을수록 먼저 실행됨) */
+	};
+	int tickets;						/* 자신의 tickets (STRIDE_TICKETS_MIN ~ STRIDE_TICKETS_MAX) */
+	int64_t donated_tickets;			/* 가진 lock들을 기다리는 thread들이 빌려준 tickets의 합 */
+
+	/* ready 상태일 때 run queue tree에 연결되는 노드
+	  - EDF thread도 budget을 다 써서 throttle 된 동안에만 fair/stride tree에 들어가므로
+	    한 thread는 한 번에 세 tree 중 하나에만 들어 있음 */
+	union {
+		struct rb_elem fair_elem;		/* fair_tree */
+		struct rb_elem stride_elem;		/* stride_tree */
+		struct rb_elem edf_elem;		/* edf_tree */
+	};
+
+	/* EDF(real-time) 관련 멤버: edf_period가 0이면 EDF thread가 아님 (단위는 모두 tick) */
+	int64_t edf_runtime;				/* period 당 실행 가능한 시간 */
+	int64_t edf_period;					/* job이 반복되는 주기 */
+	int64_t edf_deadline;				/* period 시작으로부터 job을 끝내야 하는 시간 */
+	int64_t edf_release;				/* 현재 job이 시작된 시점 */
+	int64_t edf_abs_deadline;			/* 현재 job의 deadline 시점 */
+	int64_t edf_budget;					/* 현재 job에 남은 실행 시간 */
+	bool edf_throttled;					/* budget을 다 써서 일반 thread로 취급되는 중인지 여부 */
+	int edf_misses;						/* deadline을 넘겨 끝난 job의 수 */
 
 	/* child precess 관련 멤버 */
 	struct list children;				/* (부모 thread 입장에서) 자식 thread들을 담은 list */
@@ -129,7 +184,7 @@ struct thread {
 	struct semaphore wait_sema;			/* 현재 thread가 parent에 의해 wait되는지 여부 */
 	struct semaphore free_sema;			/* 현재 thread가 parent에 의해 회수되었는지 여부 (회수 대상은 exit_status) */
 	/* file descriptor 관련 멤버 */
-	struct file** fdt;					/* "'파일의 주소값'들을 담은 배열"에 대한 주소값 */
+	struct file** fdt;					/* "'파일의 주소값'들을 담은 배열"에 대한 주소값 (처음 필요할 때 할당, 그 전엔 NULL) */
 	int next_fd;						/* 새로운 파일을 open 시 그 파일에 부여할 fd 값 */
 	int max_fd;							/* 파일이 들어가 있는 fd의 최대값 (fork, exit에서 활용) */
 	/* executable 관련 멤버 */
@@ -147,6 +202,7 @@ struct thread {
 #endif
 
 	/* Owned by thread.c. */
+	uint64_t switch_rsp;                /* Saved stack pointer for switch_threads(). */
 	struct intr_frame tf;               /* Information for switching */
 	unsigned magic;                     /* Detects stack overflow. */
 };
@@ -156,14 +212,38 @@ struct thread {
    Controlled by kernel command-line option "-o mlfqs". */
 extern bool thread_mlfqs;
 
+/* If true, switch kernel threads with a full intr_frame and iretq.
+   Controlled by kernel command-line option "-iret-switch". */
+extern bool thread_iret_switch;
+
+/* If true, use the proportional-share scheduler.
+   Controlled by kernel command-line option "-fair". */
+extern bool thread_fair;
+
+/* If true, use the stride scheduler.
+   Controlled by kernel command-line option "-stride". */
+extern bool thread_stride;
+
+/* If true, record scheduler events and dump them at shutdown.
+   Controlled by kernel command-line option "-sched-trace". */
+extern bool thread_trace;
+
 void thread_init (void);
 void thread_start (void);
 
 void thread_tick (void);
+void thread_add_idle_ticks (int64_t cnt);
 void thread_print_stats (void);
+void thread_trace_dump (void);
 
 typedef void thread_func (void *aux);
 tid_t thread_create (const char *name, int priority, thread_func *, void *);
+tid_t thread_create_periodic (const char *name, int64_t runtime,
+		int64_t period, int64_t deadline, thread_func *, void *);
+void thread_wait_period (void);
+
+bool thread_alloc_fdt (struct thread *);
+void thread_free_fdt (struct thread *);
 
 void thread_block (void);
 void thread_unblock (struct thread *);
@@ -187,17 +267,22 @@ void thread_set_priority (int);
 // function for Priority Scheduling 
 void test_max_priority (void);
 bool thread_compare_priority (const struct list_elem *a, const struct list_elem *b, void *aux);
-bool thread_compare_donate_priority (const struct list_elem *a, const struct list_elem *b, void *aux);
 
 void donate_priority (void);
+void add_held_lock (struct lock *lock);
 void remove_with_lock (struct lock *lock);
 void refresh_priority(void);
+void donate_priority_to_readers (struct rwlock *);
+void refresh_read_boost (void);
 
 int thread_get_nice (void);
 void thread_set_nice (int);
 int thread_get_recent_cpu (void);
 int thread_get_load_avg (void);
 
+void thread_set_tickets (int);
+int thread_get_tickets (void);
+
 void do_iret (struct intr_frame *tf);
 
 #endif /* threads/thread.h */
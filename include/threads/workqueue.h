@@ -0,0 +1,37 @@
+#ifndef THREADS_WORKQUEUE_H
+#define THREADS_WORKQUEUE_H
+
+#include <list.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include "threads/synch.h"
+
+struct work;
+struct workqueue;
+
+/* Function that carries out a work item.  It may free or requeue
+   WORK. */
+typedef void work_func (struct work *work);
+
+/* A unit of deferred work.  Embed one in a larger structure and
+   use its address to get back to that structure. */
+struct work {
+	struct list_elem elem;      /* Element in pending or delayed list. */
+	work_func *func;            /* Function to run. */
+	struct workqueue *wq;       /* Queue it will run on, or null if idle. */
+	int64_t expires;            /* Tick at which delayed work is queued. */
+};
+
+void workqueue_init (void);
+struct workqueue *workqueue_create (const char *name, int thread_cnt,
+		int priority);
+
+void work_init (struct work *, work_func *);
+bool queue_work (struct workqueue *, struct work *);
+bool queue_delayed_work (struct workqueue *, struct work *, int64_t ticks);
+void flush_workqueue (struct workqueue *);
+
+void workqueue_tick (int64_t now);
+int64_t workqueue_next_tick (void);
+
+#endif /* threads/workqueue.h */
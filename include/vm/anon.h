@@ -10,5 +10,7 @@ struct anon_page {
 
 void vm_anon_init (void);
 bool anon_initializer (struct page *page, enum vm_type type, void *kva);
+void anon_share_swap (struct page *dst, struct page *src);
+void anon_print_stats (void);
 
 #endif
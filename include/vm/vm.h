@@ -32,6 +32,7 @@ enum vm_type {
 #endif
 // ADD
 #include <hash.h>
+#include <list.h>
 
 struct page_operations;
 struct thread;
@@ -51,6 +52,9 @@ struct page {
 	/* supplemental page table 관련 */
 	struct hash_elem h_elem;
 	bool writable;
+	/* rmap 관련: 이 page를 mapping한 thread(pml4)와 frame->pages 연결고리 */
+	struct thread *owner;
+	struct list_elem f_elem;
 
 	/* Per-type data are binded into the union.
 	 * Each function automatically detects the current union */
@@ -64,13 +68,26 @@ struct page {
 	};
 };
 
+/* frame이 속한 page replacement list */
+enum frame_lru {
+	LRU_NONE,              /* 어느 list에도 없음 (할당 직후, evict 중) */
+	LRU_ACTIVE,            /* 최근에 참조된 frame */
+	LRU_INACTIVE           /* evict 후보 */
+};
+
 /* The representation of "frame" */
 struct frame {
 	void *kva;
 	struct page *page;
 	/* frame table 관련: data structure를 list 로 결정 */
 	struct list_elem elem;
-	struct thread *thread;
+	/* rmap: 이 frame을 mapping 중인 page들과 그 수
+	  - 각 page의 (owner->pml4, va)가 실제 mapping (COW 공유 시 여러 개)
+	*/
+	struct list pages;
+	int share_cnt;
+	int pin_cnt;           /* 0보다 크면 evict 대상에서 제외 */
+	enum frame_lru lru;
 };
 
 /* The function table for page operations.
@@ -106,7 +123,11 @@ struct page *spt_find_page (struct supplemental_page_table *spt,
 bool spt_insert_page (struct supplemental_page_table *spt, struct page *page);
 void spt_remove_page (struct supplemental_page_table *spt, struct page *page);
 
+/* -vm-clock: active/inactive LRU 대신 single-list clock 사용 */
+extern bool vm_clock;
+
 void vm_init (void);
+void vm_print_stats (void);
 bool vm_try_handle_fault (struct intr_frame *f, void *addr, bool user,
 		bool write, bool not_present);
 
@@ -115,6 +136,7 @@ bool vm_try_handle_fault (struct intr_frame *f, void *addr, bool user,
 bool vm_alloc_page_with_initializer (enum vm_type type, void *upage,
 		bool writable, vm_initializer *init, void *aux);
 void vm_dealloc_page (struct page *page);
+void vm_frame_unmap (struct page *page);
 bool vm_claim_page (void *va);
 enum vm_type page_get_type (struct page *page);
 
@@ -0,0 +1,303 @@
+#include "rbtree.h"
+#include "../debug.h"
+
+/* Red-black tree, following the algorithms in [CLRS] chapter 13
+   "Red-Black Trees", with null pointers standing in for the
+   sentinel leaves.  The tree keeps these invariants:
+
+   1. The root is black.
+   2. A red node has no red child.
+   3. Every path from a node down to a leaf passes through the
+      same number of black nodes. */
+
+static void rotate_left (struct rb_tree *, struct rb_elem *);
+static void rotate_right (struct rb_tree *, struct rb_elem *);
+static void transplant (struct rb_tree *, struct rb_elem *, struct rb_elem *);
+static void insert_fixup (struct rb_tree *, struct rb_elem *);
+static void remove_fixup (struct rb_tree *, struct rb_elem *,
+		struct rb_elem *);
+
+/* Returns true if E is a red node, false if it is black or
+   null. */
+static inline bool
+is_red (const struct rb_elem *e) {
+	return e != NULL && e->red;
+}
+
+/* Initializes TREE as an empty tree ordered by LESS, given
+   auxiliary data AUX. */
+void
+rb_init (struct rb_tree *tree, rb_less_func *less, void *aux) {
+	ASSERT (tree != NULL);
+	ASSERT (less != NULL);
+
+	tree->root = NULL;
+	tree->min = NULL;
+	tree->elem_cnt = 0;
+	tree->less = less;
+	tree->aux = aux;
+}
+
+/* Inserts NEW into TREE, after any elements equal to it. */
+void
+rb_insert (struct rb_tree *tree, struct rb_elem *new) {
+	struct rb_elem *parent = NULL;
+	struct rb_elem **link = &tree->root;
+	bool leftmost = true;
+
+	ASSERT (tree != NULL);
+	ASSERT (new != NULL);
+
+	while (*link != NULL) {
+		parent = *link;
+		if (tree->less (new, parent, tree->aux))
+			link = &parent->left;
+		else {
+			link = &parent->right;
+			leftmost = false;
+		}
+	}
+
+	new->parent = parent;
+	new->left = new->right = NULL;
+	new->red = true;
+	*link = new;
+	if (leftmost)
+		tree->min = new;
+	tree->elem_cnt++;
+
+	insert_fixup (tree, new);
+}
+
+/* Removes E, which must be in TREE. */
+void
+rb_remove (struct rb_tree *tree, struct rb_elem *e) {
+	struct rb_elem *y = e;          /* Node actually unlinked. */
+	struct rb_elem *x;              /* Node that moves into Y's place. */
+	struct rb_elem *x_parent;       /* Parent of X, since X may be null. */
+	bool y_was_red = y->red;
+
+	ASSERT (tree != NULL);
+	ASSERT (e != NULL);
+	ASSERT (tree->elem_cnt > 0);
+
+	if (tree->min == e)
+		tree->min = rb_next (e);
+
+	if (e->left == NULL) {
+		x = e->right;
+		x_parent = e->parent;
+		transplant (tree, e, e->right);
+	} else if (e->right == NULL) {
+		x = e->left;
+		x_parent = e->parent;
+		transplant (tree, e, e->left);
+	} else {
+		/* Replace E by its successor Y. */
+		y = e->right;
+		while (y->left != NULL)
+			y = y->left;
+		y_was_red = y->red;
+		x = y->right;
+		if (y->parent == e)
+			x_parent = y;
+		else {
+			x_parent = y->parent;
+			transplant (tree, y, y->right);
+			y->right = e->right;
+			y->right->parent = y;
+		}
+		transplant (tree, e, y);
+		y->left = e->left;
+		y->left->parent = y;
+		y->red = e->red;
+	}
+	tree->elem_cnt--;
+
+	if (!y_was_red)
+		remove_fixup (tree, x, x_parent);
+}
+
+/* Returns the smallest element in TREE, or a null pointer if
+   TREE is empty. */
+struct rb_elem *
+rb_min (struct rb_tree *tree) {
+	return tree->min;
+}
+
+/* Returns the element that follows E in its tree, or a null
+   pointer if E is the largest element. */
+struct rb_elem *
+rb_next (struct rb_elem *e) {
+	ASSERT (e != NULL);
+
+	if (e->right != NULL) {
+		e = e->right;
+		while (e->left != NULL)
+			e = e->left;
+		return e;
+	}
+	while (e->parent != NULL && e == e->parent->right)
+		e = e->parent;
+	return e->parent;
+}
+
+/* Returns the number of elements in TREE. */
+size_t
+rb_size (struct rb_tree *tree) {
+	return tree->elem_cnt;
+}
+
+/* Returns true if TREE contains no elements, false otherwise. */
+bool
+rb_empty (struct rb_tree *tree) {
+	return tree->elem_cnt == 0;
+}
+
+/* Makes V take the place of U in U's parent.  V may be null. */
+static void
+transplant (struct rb_tree *tree, struct rb_elem *u, struct rb_elem *v) {
+	if (u->parent == NULL)
+		tree->root = v;
+	else if (u == u->parent->left)
+		u->parent->left = v;
+	else
+		u->parent->right = v;
+	if (v != NULL)
+		v->parent = u->parent;
+}
+
+/* Rotates the subtree rooted at X to the left, so that X's right
+   child takes its place. */
+static void
+rotate_left (struct rb_tree *tree, struct rb_elem *x) {
+	struct rb_elem *y = x->right;
+
+	x->right = y->left;
+	if (y->left != NULL)
+		y->left->parent = x;
+	transplant (tree, x, y);
+	y->left = x;
+	x->parent = y;
+}
+
+/* Rotates the subtree rooted at X to the right, so that X's left
+   child takes its place. */
+static void
+rotate_right (struct rb_tree *tree, struct rb_elem *x) {
+	struct rb_elem *y = x->left;
+
+	x->left = y->right;
+	if (y->right != NULL)
+		y->right->parent = x;
+	transplant (tree, x, y);
+	y->right = x;
+	x->parent = y;
+}
+
+/* Restores the invariants after red node Z has been inserted. */
+static void
+insert_fixup (struct rb_tree *tree, struct rb_elem *z) {
+	while (is_red (z->parent)) {
+		struct rb_elem *p = z->parent;
+		struct rb_elem *g = p->parent;
+
+		if (p == g->left) {
+			struct rb_elem *u = g->right;
+			if (is_red (u)) {
+				p->red = u->red = false;
+				g->red = true;
+				z = g;
+			} else {
+				if (z == p->right) {
+					z = p;
+					rotate_left (tree, z);
+					p = z->parent;
+				}
+				p->red = false;
+				g->red = true;
+				rotate_right (tree, g);
+			}
+		} else {
+			struct rb_elem *u = g->left;
+			if (is_red (u)) {
+				p->red = u->red = false;
+				g->red = true;
+				z = g;
+			} else {
+				if (z == p->left) {
+					z = p;
+					rotate_right (tree, z);
+					p = z->parent;
+				}
+				p->red = false;
+				g->red = true;
+				rotate_left (tree, g);
+			}
+		}
+	}
+	tree->root->red = false;
+}
+
+/* Restores the invariants after a black node has been removed.
+   X, which may be null, took the removed node's place and is
+   short one black node; PARENT is X's parent. */
+static void
+remove_fixup (struct rb_tree *tree, struct rb_elem *x,
+		struct rb_elem *parent) {
+	while (x != tree->root && !is_red (x)) {
+		if (x == parent->left) {
+			struct rb_elem *w = parent->right;
+			if (is_red (w)) {
+				w->red = false;
+				parent->red = true;
+				rotate_left (tree, parent);
+				w = parent->right;
+			}
+			if (!is_red (w->left) && !is_red (w->right)) {
+				w->red = true;
+				x = parent;
+				parent = x->parent;
+			} else {
+				if (!is_red (w->right)) {
+					w->left->red = false;
+					w->red = true;
+					rotate_right (tree, w);
+					w = parent->right;
+				}
+				w->red = parent->red;
+				parent->red = false;
+				w->right->red = false;
+				rotate_left (tree, parent);
+				x = tree->root;
+			}
+		} else {
+			struct rb_elem *w = parent->left;
+			if (is_red (w)) {
+				w->red = false;
+				parent->red = true;
+				rotate_right (tree, parent);
+				w = parent->left;
+			}
+			if (!is_red (w->left) && !is_red (w->right)) {
+				w->red = true;
+				x = parent;
+				parent = x->parent;
+			} else {
+				if (!is_red (w->left)) {
+					w->right->red = false;
+					w->red = true;
+					rotate_left (tree, w);
+					w = parent->left;
+				}
+				w->red = parent->red;
+				parent->red = false;
+				w->left->red = false;
+				rotate_right (tree, parent);
+				x = tree->root;
+			}
+		}
+	}
+	if (x != NULL)
+		x->red = false;
+}
@@ -0,0 +1,79 @@
+/* Puts SLEEPER_CNT threads to sleep at once, more than one page
+   of the sleep heap can hold, so that the heap has to grow past
+   its first page, and checks that each of them wakes up on the
+   tick it asked for.  A second round checks that the grown heap
+   keeps working once it has been emptied. */
+
+#include <stdio.h>
+#include "tests/threads/tests.h"
+#include "threads/init.h"
+#include "threads/synch.h"
+#include "threads/thread.h"
+#include "devices/timer.h"
+
+#define SLEEPER_CNT 600
+#define SPREAD 10
+#define ROUND_CNT 2
+
+/* Information about one sleeper. */
+struct sleeper
+  {
+    int64_t wake_tick;          /* Tick to wake up at. */
+    int64_t woke_tick;          /* Tick actually woken up at. */
+  };
+
+static thread_func sleeper_thread;
+static struct sleeper sleepers[SLEEPER_CNT];
+static struct semaphore done_sema;
+
+void
+test_alarm_many (void)
+{
+  int round, i;
+
+  /* This test does not work with the MLFQS. */
+  ASSERT (!thread_mlfqs);
+
+  sema_init (&done_sema, 0);
+  for (round = 0; round < ROUND_CNT; round++)
+    {
+      int64_t start = timer_ticks () + TIMER_FREQ;
+      int late_cnt = 0;
+
+      msg ("Round %d: putting %d threads to sleep at once.",
+           round + 1, SLEEPER_CNT);
+      for (i = 0; i < SLEEPER_CNT; i++)
+        {
+          char name[16];
+          sleepers[i].wake_tick = start + 1 + i % SPREAD;
+          snprintf (name, sizeof name, "sleeper %d", i);
+          if (thread_create (name, PRI_DEFAULT + 1, sleeper_thread,
+                             &sleepers[i]) == TID_ERROR)
+            fail ("couldn't create thread %d", i);
+        }
+      if (timer_ticks () >= start)
+        fail ("creating the sleepers took more than %d ticks", TIMER_FREQ);
+
+      for (i = 0; i < SLEEPER_CNT; i++)
+        sema_down (&done_sema);
+      for (i = 0; i < SLEEPER_CNT; i++)
+        if (sleepers[i].woke_tick != sleepers[i].wake_tick)
+          late_cnt++;
+      if (late_cnt != 0)
+        fail ("%d sleepers did not wake up on their tick", late_cnt);
+      msg ("Round %d: all %d sleepers woke up on time.",
+           round + 1, SLEEPER_CNT);
+    }
+}
+
+/* Sleeper thread.  Has a higher priority than the main thread,
+   so it goes to sleep as soon as it is created. */
+static void
+sleeper_thread (void *sleeper_)
+{
+  struct sleeper *sleeper = sleeper_;
+
+  timer_sleep (sleeper->wake_tick - timer_ticks ());
+  sleeper->woke_tick = timer_ticks ();
+  sema_up (&done_sema);
+}
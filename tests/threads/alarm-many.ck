@@ -0,0 +1,13 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+check_expected ([<<'EOF']);
+(alarm-many) begin
+(alarm-many) Round 1: putting 600 threads to sleep at once.
+(alarm-many) Round 1: all 600 sleepers woke up on time.
+(alarm-many) Round 2: putting 600 threads to sleep at once.
+(alarm-many) Round 2: all 600 sleepers woke up on time.
+(alarm-many) end
+EOF
+pass;
@@ -0,0 +1,104 @@
+/* Puts SLEEPER_CNT threads to sleep at the same time, each until
+   one of SPREAD consecutive ticks, and verifies that every one of
+   them wakes up on exactly the tick it asked for.
+
+   Also reports how many ticks it took to put all of the sleepers
+   to sleep and to wake all of them up, as a rough benchmark of
+   the sleep queue. */
+
+#include <stdio.h>
+#include "tests/threads/tests.h"
+#include "threads/init.h"
+#include "threads/malloc.h"
+#include "threads/synch.h"
+#include "threads/thread.h"
+#include "devices/timer.h"
+
+#define SLEEPER_CNT 10000
+#define SPREAD 100
+
+/* Information about one sleeper. */
+struct sleeper
+  {
+    int64_t wake_tick;          /* Tick to wake up at. */
+    int64_t woke_tick;          /* Tick actually woken up at. */
+  };
+
+static thread_func sleeper_thread;
+static struct semaphore go_sema;
+static struct semaphore done_sema;
+
+void
+test_alarm_stress (void) 
+{
+  struct sleeper *sleepers;
+  int64_t start, released, woken;
+  int late_cnt;
+  int i;
+
+  /* This test does not work with the MLFQS. */
+  ASSERT (!thread_mlfqs);
+
+  msg ("Creating %d sleeper threads.", SLEEPER_CNT);
+  msg ("Each sleeper wakes up on one of %d consecutive ticks.", SPREAD);
+
+  sleepers = malloc (sizeof *sleepers * SLEEPER_CNT);
+  if (sleepers == NULL)
+    PANIC ("couldn't allocate memory for test");
+
+  sema_init (&go_sema, 0);
+  sema_init (&done_sema, 0);
+
+  /* Sleepers have a higher priority than us, so each one runs
+     right away and waits on GO_SEMA. */
+  for (i = 0; i < SLEEPER_CNT; i++) 
+    {
+      char name[16];
+      snprintf (name, sizeof name, "sleeper %d", i);
+      if (thread_create (name, PRI_DEFAULT + 1, sleeper_thread,
+                         &sleepers[i]) == TID_ERROR)
+        fail ("couldn't create thread %d", i);
+    }
+
+  /* Release the sleepers one by one.  Each one preempts us and
+     goes to sleep immediately. */
+  start = timer_ticks () + TIMER_FREQ;
+  for (i = 0; i < SLEEPER_CNT; i++) 
+    sleepers[i].wake_tick = start + 1 + i % SPREAD;
+  released = timer_ticks ();
+  for (i = 0; i < SLEEPER_CNT; i++) 
+    sema_up (&go_sema);
+  released = timer_elapsed (released);
+  if (timer_ticks () >= start)
+    fail ("releasing the sleepers took more than %d ticks", TIMER_FREQ);
+
+  /* Sleep through the wake-up window, then collect everyone. */
+  timer_sleep (start + SPREAD + 1 - timer_ticks ());
+  for (i = 0; i < SLEEPER_CNT; i++) 
+    sema_down (&done_sema);
+  woken = timer_elapsed (start);
+
+  late_cnt = 0;
+  for (i = 0; i < SLEEPER_CNT; i++) 
+    if (sleepers[i].woke_tick != sleepers[i].wake_tick)
+      late_cnt++;
+  if (late_cnt != 0)
+    fail ("%d sleepers did not wake up on their tick", late_cnt);
+  msg ("All %d sleepers woke up on time.", SLEEPER_CNT);
+  msg ("Benchmark: released in %lld ticks, all woken after %lld ticks.",
+       released, woken);
+
+  free (sleepers);
+}
+
+/* Sleeper thread. */
+static void
+sleeper_thread (void *sleeper_) 
+{
+  struct sleeper *sleeper = sleeper_;
+
+  sema_down (&go_sema);
+  timer_sleep (sleeper->wake_tick - timer_ticks ());
+  sleeper->woke_tick = timer_ticks ();
+  sema_up (&done_sema);
+}
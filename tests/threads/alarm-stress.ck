@@ -0,0 +1,30 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+
+our ($test);
+my (@output) = read_text_file ("$test.output");
+common_checks ("run", @output);
+
+# Releasing all the sleepers must take less than the second
+# (100 ticks) before the first wake-up tick, and nobody can be
+# collected before the last of the 100 wake-up ticks has passed.
+my ($released, $woken) = map (/^\(alarm-stress\) Benchmark: released in (\d+) ticks, all woken after (\d+) ticks\.$/, @output);
+fail "missing benchmark results\n" if !defined $woken;
+fail "releasing the sleepers took $released ticks, not under 100\n"
+  if $released >= 100;
+fail "all sleepers collected after $woken ticks, before the wake-up window closed\n"
+  if $woken <= 100;
+
+s/released in \d+ ticks, all woken after \d+ ticks/released in R ticks, all woken after W ticks/
+  foreach @output;
+compare_output ("run", \@output, [<<'EOF']);
+(alarm-stress) begin
+(alarm-stress) Creating 10000 sleeper threads.
+(alarm-stress) Each sleeper wakes up on one of 100 consecutive ticks.
+(alarm-stress) All 10000 sleepers woke up on time.
+(alarm-stress) Benchmark: released in R ticks, all woken after W ticks.
+(alarm-stress) end
+EOF
+pass;
@@ -0,0 +1,161 @@
+/* Producer/consumer benchmark for condition variables with
+   WAITER_CNT consumers blocked in cond_wait() at a spread of
+   priorities.
+
+   The first phase hands out items one at a time with
+   cond_signal(), so each signal picks the highest-priority
+   waiter among WAITER_CNT.  The second phase wakes every waiter
+   with cond_broadcast() for BROADCAST_CNT rounds.  Both phases
+   check that no wakeup is lost and report their throughput. */
+
+#include <stdio.h>
+#include "tests/threads/tests.h"
+#include "threads/init.h"
+#include "threads/synch.h"
+#include "threads/thread.h"
+#include "devices/timer.h"
+
+#define WAITER_CNT 256
+#define ITEM_CNT (WAITER_CNT * 40)
+#define BROADCAST_CNT 40
+
+static thread_func signal_consumer;
+static thread_func broadcast_consumer;
+
+static struct lock lock;
+static struct condition not_empty;      /* Signaled when ITEMS grows. */
+static struct condition all_waiting;    /* Signaled when WAITING reaches WAITER_CNT. */
+static struct condition next_round;     /* Broadcast when GENERATION changes. */
+static struct semaphore done_sema;
+
+static int items;                       /* Items produced but not consumed. */
+static int consumed;                    /* Items consumed so far. */
+static bool closed;                     /* No more items will be produced. */
+static int generation;                  /* Broadcast round number. */
+static int waiting;                     /* Consumers waiting for NEXT_ROUND. */
+static int wakeups;                     /* Wakeups seen from broadcasts. */
+
+static void start_consumers (thread_func *);
+static void report (const char *what, int cnt, int64_t elapsed);
+
+void
+test_condvar_pc (void) 
+{
+  int64_t start;
+  int i;
+
+  /* This test does not work with the MLFQS. */
+  ASSERT (!thread_mlfqs);
+
+  lock_init (&lock);
+  cond_init (&not_empty);
+  cond_init (&all_waiting);
+  cond_init (&next_round);
+  sema_init (&done_sema, 0);
+
+  /* Phase 1: one cond_signal() per item. */
+  msg ("Producing %d items for %d waiting consumers.", ITEM_CNT, WAITER_CNT);
+  start_consumers (signal_consumer);
+  start = timer_ticks ();
+  for (i = 0; i < ITEM_CNT; i++) 
+    {
+      lock_acquire (&lock);
+      items++;
+      cond_signal (&not_empty, &lock);
+      lock_release (&lock);
+    }
+  lock_acquire (&lock);
+  closed = true;
+  cond_broadcast (&not_empty, &lock);
+  lock_release (&lock);
+  for (i = 0; i < WAITER_CNT; i++)
+    sema_down (&done_sema);
+  report ("signal", ITEM_CNT, timer_elapsed (start));
+  if (consumed != ITEM_CNT)
+    fail ("%d of %d items consumed.", consumed, ITEM_CNT);
+
+  /* Phase 2: one cond_broadcast() per round wakes everyone. */
+  msg ("Broadcasting to %d waiting consumers %d times.",
+       WAITER_CNT, BROADCAST_CNT);
+  start_consumers (broadcast_consumer);
+  start = timer_ticks ();
+  lock_acquire (&lock);
+  for (i = 0; i < BROADCAST_CNT; i++) 
+    {
+      while (waiting < WAITER_CNT)
+        cond_wait (&all_waiting, &lock);
+      waiting = 0;
+      generation++;
+      cond_broadcast (&next_round, &lock);
+    }
+  lock_release (&lock);
+  for (i = 0; i < WAITER_CNT; i++)
+    sema_down (&done_sema);
+  report ("broadcast", WAITER_CNT * BROADCAST_CNT, timer_elapsed (start));
+  if (wakeups != WAITER_CNT * BROADCAST_CNT)
+    fail ("%d of %d broadcast wakeups seen.",
+          wakeups, WAITER_CNT * BROADCAST_CNT);
+
+  msg ("No wakeups lost.");
+}
+
+/* Starts WAITER_CNT threads running FUNC, at priorities above
+   ours so that each one is waiting before we go on. */
+static void
+start_consumers (thread_func *func) 
+{
+  int i;
+
+  for (i = 0; i < WAITER_CNT; i++) 
+    {
+      char name[16];
+      snprintf (name, sizeof name, "consumer %d", i);
+      thread_create (name, PRI_DEFAULT + 1 + i % 16, func, NULL);
+    }
+}
+
+static void
+report (const char *what, int cnt, int64_t elapsed) 
+{
+  if (elapsed == 0)
+    elapsed = 1;
+  msg ("Benchmark (%s): %d wakeups in %lld ticks, %lld wakeups/s.",
+       what, cnt, elapsed, (long long) cnt * TIMER_FREQ / elapsed);
+}
+
+static void
+signal_consumer (void *aux UNUSED) 
+{
+  lock_acquire (&lock);
+  for (;;) 
+    {
+      while (items == 0 && !closed)
+        cond_wait (&not_empty, &lock);
+      if (items == 0)
+        break;
+      items--;
+      consumed++;
+    }
+  lock_release (&lock);
+  sema_up (&done_sema);
+}
+
+static void
+broadcast_consumer (void *aux UNUSED) 
+{
+  int i;
+
+  lock_acquire (&lock);
+  for (i = 0; i < BROADCAST_CNT; i++) 
+    {
+      int round = generation;
+
+      if (++waiting == WAITER_CNT)
+        cond_signal (&all_waiting, &lock);
+      while (generation == round)
+        cond_wait (&next_round, &lock);
+      wakeups++;
+    }
+  lock_release (&lock);
+  sema_up (&done_sema);
+}
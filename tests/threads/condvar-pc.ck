@@ -0,0 +1,29 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+
+our ($test);
+my (@output) = read_text_file ("$test.output");
+common_checks ("run", @output);
+
+# Each phase delivers all 10240 wakeups (256 consumers times 40)
+# and reports the rate they came at.
+foreach my $what ("signal", "broadcast") {
+    my ($ticks, $rate) = map (/^\(condvar-pc\) Benchmark \($what\): 10240 wakeups in (\d+) ticks, (\d+) wakeups\/s\.$/, @output);
+    fail "missing $what benchmark results\n" if !defined $rate;
+    fail "10240 wakeups in $ticks ticks is not $rate wakeups/s\n"
+      if $ticks == 0 || $rate != int (10240 * 100 / $ticks);
+}
+
+s/in \d+ ticks, \d+ wakeups/in T ticks, R wakeups/ foreach @output;
+compare_output ("run", \@output, [<<'EOF']);
+(condvar-pc) begin
+(condvar-pc) Producing 10240 items for 256 waiting consumers.
+(condvar-pc) Benchmark (signal): 10240 wakeups in T ticks, R wakeups/s.
+(condvar-pc) Broadcasting to 256 waiting consumers 40 times.
+(condvar-pc) Benchmark (broadcast): 10240 wakeups in T ticks, R wakeups/s.
+(condvar-pc) No wakeups lost.
+(condvar-pc) end
+EOF
+pass;
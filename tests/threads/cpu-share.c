@@ -0,0 +1,136 @@
+/* Runs CPU-bound threads against each other for a few seconds and
+   checks that each one gets its share of the CPU, within a given
+   error.
+
+   fair-share runs 8 threads of equal priority under the
+   proportional-share scheduler, so each should get 1/8 of the CPU,
+   within 10%.  stride-share runs threads holding 100, 200, 300 and
+   400 tickets under the stride scheduler, so they should get 10%,
+   20%, 30% and 40%, each within 5%.
+
+   Both also report the largest relative error, as a benchmark of
+   the scheduler's accuracy. */
+
+#include <stdio.h>
+#include "tests/threads/tests.h"
+#include "threads/init.h"
+#include "threads/synch.h"
+#include "threads/thread.h"
+#include "devices/timer.h"
+
+#define THREAD_MAX 8
+
+/* One CPU-bound thread. */
+struct spinner
+  {
+    int share;                  /* Target share, relative to the others. */
+    int64_t count;              /* Loop iterations it got through. */
+  };
+
+static void test_share (int thread_cnt, const int shares[],
+                        int seconds, int max_error);
+
+void
+test_fair_share (void)
+{
+  static const int shares[] = {1, 1, 1, 1, 1, 1, 1, 1};
+
+  /* This test needs the proportional-share scheduler. */
+  ASSERT (thread_fair);
+
+  msg ("Starting 8 CPU-bound threads at equal priority.");
+  test_share (8, shares, 5, 1000);
+}
+
+void
+test_stride_share (void)
+{
+  static const int shares[] = {100, 200, 300, 400};
+
+  /* This test needs the stride scheduler. */
+  ASSERT (thread_stride);
+
+  msg ("Starting 4 CPU-bound threads with 100 to 400 tickets.");
+  test_share (4, shares, 10, 500);
+}
+
+static thread_func spinner_thread;
+static struct semaphore go_sema;
+static struct semaphore done_sema;
+static volatile bool stop;
+static struct spinner spinners[THREAD_MAX];
+
+/* Runs THREAD_CNT spinners for SECONDS seconds, spinner I aiming
+   for SHARES[I] / (sum of SHARES) of the CPU, and fails if any of
+   them misses its target by more than MAX_ERROR hundredths of a
+   percent of that target.  Under the stride scheduler each
+   spinner's share is its number of tickets. */
+static void
+test_share (int thread_cnt, const int shares[], int seconds, int max_error)
+{
+  int64_t total, worst;
+  int i, total_shares = 0;
+
+  ASSERT (thread_cnt <= THREAD_MAX);
+
+  sema_init (&go_sema, 0);
+  sema_init (&done_sema, 0);
+  stop = false;
+  for (i = 0; i < thread_cnt; i++)
+    {
+      char name[16];
+      spinners[i].share = shares[i];
+      spinners[i].count = 0;
+      total_shares += shares[i];
+      snprintf (name, sizeof name, "spinner %d", i);
+      thread_create (name, PRI_DEFAULT, spinner_thread, &spinners[i]);
+    }
+
+  /* Start everyone at once, then let them compete. */
+  for (i = 0; i < thread_cnt; i++)
+    sema_up (&go_sema);
+  timer_sleep (seconds * TIMER_FREQ);
+  stop = true;
+  for (i = 0; i < thread_cnt; i++)
+    sema_down (&done_sema);
+
+  total = 0;
+  for (i = 0; i < thread_cnt; i++)
+    total += spinners[i].count;
+  if (total == 0)
+    fail ("spinner threads never ran");
+
+  /* Deviation of each share from its target, relative to that
+     target, in hundredths of a percent. */
+  worst = 0;
+  for (i = 0; i < thread_cnt; i++)
+    {
+      int64_t error = spinners[i].count * total_shares * 10000
+                      / (total * spinners[i].share) - 10000;
+      if (error < 0)
+        error = -error;
+      if (error > worst)
+        worst = error;
+    }
+  if (worst > max_error)
+    fail ("a thread's CPU share was off by %lld.%02lld%%",
+          worst / 100, worst % 100);
+  msg ("Every thread got its share of the CPU.");
+  msg ("Benchmark: max CPU share error %lld.%02lld%% over %d threads.",
+       worst / 100, worst % 100, thread_cnt);
+}
+
+/* Takes its tickets under the stride scheduler, then spins,
+   counting iterations, until told to stop. */
+static void
+spinner_thread (void *spinner_)
+{
+  struct spinner *s = spinner_;
+
+  if (thread_stride)
+    thread_set_tickets (s->share);
+  sema_down (&go_sema);
+  while (!stop)
+    s->count++;
+  sema_up (&done_sema);
+}
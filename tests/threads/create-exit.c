@@ -0,0 +1,48 @@
+/* Creates and reaps THREAD_CNT short-lived threads one after
+   another, and reports how many thread create/exit cycles per
+   second that achieves.  Exited threads' pages are recycled, so
+   this mostly measures the cached path. */
+
+#include <stdio.h>
+#include "tests/threads/tests.h"
+#include "threads/init.h"
+#include "threads/synch.h"
+#include "threads/thread.h"
+#include "devices/timer.h"
+
+#define THREAD_CNT 10000
+
+static thread_func exit_thread;
+static struct semaphore done_sema;
+
+void
+test_create_exit (void) 
+{
+  int64_t start, elapsed;
+  int i;
+
+  sema_init (&done_sema, 0);
+
+  msg ("Creating and reaping %d threads.", THREAD_CNT);
+  start = timer_ticks ();
+  for (i = 0; i < THREAD_CNT; i++) 
+    {
+      if (thread_create ("exiter", PRI_DEFAULT, exit_thread, NULL)
+          == TID_ERROR)
+        fail ("thread_create failed after %d threads.", i);
+      sema_down (&done_sema);
+    }
+  elapsed = timer_elapsed (start);
+
+  msg ("Done.");
+  if (elapsed == 0)
+    elapsed = 1;
+  msg ("Benchmark: %d threads in %lld ticks, %lld threads/s.",
+       THREAD_CNT, elapsed, (long long) THREAD_CNT * TIMER_FREQ / elapsed);
+}
+
+static void
+exit_thread (void *aux UNUSED) 
+{
+  sema_up (&done_sema);
+}
@@ -0,0 +1,25 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+
+our ($test);
+my (@output) = read_text_file ("$test.output");
+common_checks ("run", @output);
+
+# All 10000 threads must be created and reaped, one at a time, and
+# the reported rate must follow from the tick count.
+my ($ticks, $rate) = map (/^\(create-exit\) Benchmark: 10000 threads in (\d+) ticks, (\d+) threads\/s\.$/, @output);
+fail "missing benchmark results\n" if !defined $rate;
+fail "10000 threads in $ticks ticks is not $rate threads/s\n"
+  if $ticks == 0 || $rate != int (10000 * 100 / $ticks);
+
+s/in \d+ ticks, \d+ threads/in T ticks, R threads/ foreach @output;
+compare_output ("run", \@output, [<<'EOF']);
+(create-exit) begin
+(create-exit) Creating and reaping 10000 threads.
+(create-exit) Done.
+(create-exit) Benchmark: 10000 threads in T ticks, R threads/s.
+(create-exit) end
+EOF
+pass;
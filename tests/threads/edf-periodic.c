@@ -0,0 +1,105 @@
+/* Runs two periodic real-time threads next to a CPU-bound
+   thread of the highest normal priority, and checks that every
+   job of the real-time threads meets its deadline.  Also checks
+   that admission control rejects a third real-time thread that
+   would over-subscribe the CPU. */
+
+#include <stdio.h>
+#include "tests/threads/tests.h"
+#include "threads/init.h"
+#include "threads/synch.h"
+#include "threads/thread.h"
+#include "devices/timer.h"
+
+#define JOB_CNT 20
+
+/* Parameters of one periodic thread, in ticks. */
+struct periodic
+  {
+    int64_t runtime;
+    int64_t period;
+    int64_t deadline;
+    int jobs;                   /* # of jobs run. */
+    int misses;                 /* # of deadline misses. */
+  };
+
+static thread_func periodic_thread;
+static thread_func hog_thread;
+static struct semaphore done_sema;
+static volatile int done_cnt;
+
+void
+test_edf_periodic (void) 
+{
+  struct periodic periodics[2] = {
+    { 2, 10, 10, 0, 0 },
+    { 3, 20, 15, 0, 0 },
+  };
+  int i;
+
+  /* This test does not work with the MLFQS. */
+  ASSERT (!thread_mlfqs);
+
+  sema_init (&done_sema, 0);
+  done_cnt = 0;
+
+  for (i = 0; i < 2; i++) 
+    {
+      char name[16];
+      snprintf (name, sizeof name, "periodic %d", i);
+      if (thread_create_periodic (name, periodics[i].runtime,
+                                  periodics[i].period, periodics[i].deadline,
+                                  periodic_thread, &periodics[i]) == TID_ERROR)
+        fail ("periodic thread %d was not admitted", i);
+    }
+  msg ("Admitted 2 periodic threads.");
+
+  /* 20% + 15% + 70% of the CPU is more than can be admitted. */
+  if (thread_create_periodic ("too much", 7, 10, 10,
+                              periodic_thread, NULL) != TID_ERROR)
+    fail ("over-subscribing periodic thread was admitted");
+  msg ("Over-subscribing periodic thread was rejected.");
+
+  /* The hog starves us until the periodic threads are done. */
+  thread_create ("hog", PRI_MAX, hog_thread, NULL);
+  for (i = 0; i < 2; i++) 
+    sema_down (&done_sema);
+
+  for (i = 0; i < 2; i++) 
+    {
+      if (periodics[i].jobs != JOB_CNT)
+        fail ("periodic thread %d ran %d jobs", i, periodics[i].jobs);
+      if (periodics[i].misses != 0)
+        fail ("periodic thread %d missed %d deadlines",
+              i, periodics[i].misses);
+    }
+  msg ("Every job of every periodic thread met its deadline.");
+}
+
+/* Runs JOB_CNT jobs of about one tick of work each. */
+static void
+periodic_thread (void *periodic_) 
+{
+  struct periodic *periodic = periodic_;
+  int i;
+
+  for (i = 0; i < JOB_CNT; i++) 
+    {
+      int64_t start = timer_ticks ();
+      while (timer_ticks () == start)
+        continue;
+      periodic->jobs++;
+      thread_wait_period ();
+    }
+  periodic->misses = thread_current ()->edf_misses;
+  done_cnt++;
+  sema_up (&done_sema);
+}
+
+/* Spins until both periodic threads are done. */
+static void
+hog_thread (void *aux UNUSED) 
+{
+  while (done_cnt < 2)
+    continue;
+}
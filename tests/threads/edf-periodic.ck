@@ -0,0 +1,12 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+check_expected ([<<'EOF']);
+(edf-periodic) begin
+(edf-periodic) Admitted 2 periodic threads.
+(edf-periodic) Over-subscribing periodic thread was rejected.
+(edf-periodic) Every job of every periodic thread met its deadline.
+(edf-periodic) end
+EOF
+pass;
@@ -0,0 +1,24 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+
+our ($test);
+my (@output) = read_text_file ("$test.output");
+common_checks ("run", @output);
+
+# Each of the 8 threads must get 1/8 of the CPU, within 10% of it.
+my ($error) = map (/^\(fair-share\) Benchmark: max CPU share error (\d+\.\d\d)% over 8 threads\.$/, @output);
+fail "missing benchmark results\n" if !defined $error;
+fail "a thread's CPU share was off by $error%, more than 10%\n"
+  if $error > 10;
+
+s/error \d+\.\d\d%/error X%/ foreach @output;
+compare_output ("run", \@output, [<<'EOF']);
+(fair-share) begin
+(fair-share) Starting 8 CPU-bound threads at equal priority.
+(fair-share) Every thread got its share of the CPU.
+(fair-share) Benchmark: max CPU share error X% over 8 threads.
+(fair-share) end
+EOF
+pass;
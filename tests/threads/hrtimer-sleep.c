@@ -0,0 +1,76 @@
+/* Checks high-resolution sleeps: sub-tick timer_usleep() calls
+   block instead of spinning, so a lower-priority thread gets to
+   run meanwhile, never return early, and together take far less
+   time than rounding each one up to a whole tick would.  Also
+   checks that a cancelled hrtimer does not fire. */
+
+#include <stdio.h>
+#include "tests/threads/tests.h"
+#include "threads/init.h"
+#include "threads/synch.h"
+#include "threads/thread.h"
+#include "devices/timer.h"
+
+#define SLEEP_CNT 100
+#define SLEEP_US 500
+
+static volatile bool done;
+static volatile long long spins;
+static struct semaphore spinner_done;
+static int fired;
+
+static void
+spinner (void *aux UNUSED) 
+{
+  while (!done)
+    spins++;
+  sema_up (&spinner_done);
+}
+
+static void
+count_fired (struct hrtimer *timer UNUSED) 
+{
+  fired++;
+}
+
+void
+test_hrtimer_sleep (void) 
+{
+  struct hrtimer kept, cancelled;
+  int64_t start, total;
+  int i;
+
+  sema_init (&spinner_done, 0);
+  thread_create ("spinner", PRI_DEFAULT - 1, spinner, NULL);
+
+  msg ("Sleeping %d times for %d us.", SLEEP_CNT, SLEEP_US);
+  start = timer_now_ns ();
+  for (i = 0; i < SLEEP_CNT; i++) 
+    {
+      int64_t before = timer_now_ns ();
+      timer_usleep (SLEEP_US);
+      if (timer_now_ns () - before < SLEEP_US * 1000LL)
+        fail ("Sleep %d returned after only %lld ns.",
+              i, timer_now_ns () - before);
+    }
+  total = timer_now_ns () - start;
+  done = true;
+  sema_down (&spinner_done);
+
+  if (total >= SLEEP_CNT * 1000000000LL / TIMER_FREQ / 2)
+    fail ("Sleeps took %lld ns in total.", total);
+  if (spins == 0)
+    fail ("Lower-priority thread never ran while we slept.");
+  msg ("Sleeps blocked and woke up on time.");
+
+  hrtimer_init (&kept, count_fired);
+  hrtimer_init (&cancelled, count_fired);
+  hrtimer_start (&kept, timer_now_ns () + 200 * 1000);
+  hrtimer_start (&cancelled, timer_now_ns () + 100 * 1000);
+  if (!hrtimer_cancel (&cancelled))
+    fail ("Cancelled an inactive hrtimer.");
+  timer_msleep (1);
+  if (hrtimer_cancel (&kept))
+    fail ("hrtimer still active after its expiry.");
+  msg ("%d hrtimer fired.", fired);
+}
@@ -0,0 +1,12 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+check_expected ([<<'EOF']);
+(hrtimer-sleep) begin
+(hrtimer-sleep) Sleeping 100 times for 500 us.
+(hrtimer-sleep) Sleeps blocked and woke up on time.
+(hrtimer-sleep) 1 hrtimer fired.
+(hrtimer-sleep) end
+EOF
+pass;
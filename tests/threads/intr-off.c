@@ -0,0 +1,89 @@
+/* Measures the longest time interrupts stay off while
+   SLEEPER_CNT threads keep sleeping for one tick at a time, so
+   that every timer interrupt has wakeups and bottom-half work to
+   do.  The longest window must be shorter than one timer tick, or
+   timer interrupts would be lost.
+
+   Needs a kernel built with `make INTR_PROFILE=1'; otherwise there
+   is nothing to measure and the test only says so. */
+
+#include <stdio.h>
+#include <inttypes.h>
+#include "tests/threads/tests.h"
+#include "threads/init.h"
+#include "threads/interrupt.h"
+#include "threads/synch.h"
+#include "threads/thread.h"
+#include "devices/timer.h"
+#include "intrinsic.h"
+
+#define SLEEPER_CNT 32
+#define SLEEP_CNT 50
+#define CALIBRATE_TICKS 10
+
+#ifdef INTR_PROFILE
+static thread_func sleeper_thread;
+static struct semaphore done_sema;
+
+/* Returns the number of TSC cycles in one timer tick, measured
+   over CALIBRATE_TICKS ticks. */
+static uint64_t
+cycles_per_tick (void)
+{
+  int64_t start_tick = timer_ticks ();
+  uint64_t start;
+
+  while (timer_ticks () == start_tick)
+    continue;
+  start = rdtsc ();
+  while (timer_ticks () < start_tick + 1 + CALIBRATE_TICKS)
+    continue;
+  return (rdtsc () - start) / CALIBRATE_TICKS;
+}
+#endif
+
+void
+test_intr_off (void)
+{
+#ifdef INTR_PROFILE
+  uint64_t tick, max;
+  int i;
+
+  tick = cycles_per_tick ();
+  sema_init (&done_sema, 0);
+  intr_reset_stats ();
+  for (i = 0; i < SLEEPER_CNT; i++)
+    {
+      char name[16];
+      snprintf (name, sizeof name, "sleeper %d", i);
+      thread_create (name, PRI_DEFAULT, sleeper_thread, NULL);
+    }
+  for (i = 0; i < SLEEPER_CNT; i++)
+    sema_down (&done_sema);
+  max = intr_off_max_cycles ();
+
+  msg ("Benchmark: longest interrupt-off window %"PRIu64" kcycles, "
+       "one tick %"PRIu64" kcycles.", max / 1000, tick / 1000);
+  if (max == 0)
+    fail ("no interrupt-off window was measured");
+  if (max >= tick)
+    fail ("interrupts stayed off for %"PRIu64" cycles, "
+          "longer than a tick of %"PRIu64" cycles", max, tick);
+  msg ("Interrupts stayed off for less than one tick.");
+#else
+  msg ("Kernel built without INTR_PROFILE: nothing to measure.");
+#endif
+}
+
+#ifdef INTR_PROFILE
+/* Sleeps for one tick SLEEP_CNT times. */
+static void
+sleeper_thread (void *aux UNUSED)
+{
+  int i;
+
+  for (i = 0; i < SLEEP_CNT; i++)
+    timer_sleep (1);
+  sema_up (&done_sema);
+}
+#endif
@@ -0,0 +1,28 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+
+our ($test);
+my (@output) = read_text_file ("$test.output");
+common_checks ("run", @output);
+
+# In an INTR_PROFILE kernel, the longest interrupt-off window under
+# load must be shorter than a timer tick.  Other kernels only say
+# that there is nothing to measure.
+my ($max, $tick) = map (/^\(intr-off\) Benchmark: longest interrupt-off window (\d+) kcycles, one tick (\d+) kcycles\.$/, @output);
+fail "interrupts stayed off for $max kcycles, a tick is only $tick\n"
+  if defined $tick && $max >= $tick;
+
+s/window \d+ kcycles, one tick \d+ kcycles/window M kcycles, one tick T kcycles/ foreach @output;
+compare_output ("run", \@output, [<<'EOF', <<'EOF']);
+(intr-off) begin
+(intr-off) Benchmark: longest interrupt-off window M kcycles, one tick T kcycles.
+(intr-off) Interrupts stayed off for less than one tick.
+(intr-off) end
+EOF
+(intr-off) begin
+(intr-off) Kernel built without INTR_PROFILE: nothing to measure.
+(intr-off) end
+EOF
+pass;
@@ -0,0 +1,60 @@
+/* Checks that the adaptive mutex hands itself to waiters in
+   priority order, donates like a lock, and, in a kernel built
+   with LOCK_PROFILE, counts acquisitions and contention.  With one
+   CPU the holder is never running while a waiter is, so no
+   contended acquisition is won by spinning. */
+
+#include <stdio.h>
+#include "tests/threads/tests.h"
+#include "threads/init.h"
+#include "threads/synch.h"
+#include "threads/thread.h"
+
+#define WAITER_CNT 3
+
+static thread_func waiter_thread;
+static struct mutex mutex;
+
+void
+test_mutex_stats (void) 
+{
+  int i;
+
+  /* This test does not work with the MLFQS. */
+  ASSERT (!thread_mlfqs);
+
+  /* Make sure our priority is the default. */
+  ASSERT (thread_get_priority () == PRI_DEFAULT);
+
+  mutex_init (&mutex, "test");
+  mutex_acquire (&mutex);
+  for (i = 0; i < WAITER_CNT; i++) 
+    {
+      char name[16];
+      snprintf (name, sizeof name, "waiter %d", i);
+      thread_create (name, PRI_DEFAULT + 1 + i, waiter_thread, NULL);
+    }
+  msg ("Main has priority %d with %d waiters.",
+       thread_get_priority (), WAITER_CNT);
+  mutex_release (&mutex);
+
+  if (mutex_try_acquire (&mutex))
+    {
+      msg ("Try-acquire succeeded.");
+      mutex_release (&mutex);
+    }
+#ifdef LOCK_PROFILE
+  msg ("%lld acquires, %lld contended, %lld won by spinning.",
+       mutex.acquires, mutex.contended, mutex.spin_acquires);
+#else
+  msg ("Kernel built without LOCK_PROFILE: no statistics.");
+#endif
+}
+
+static void
+waiter_thread (void *aux UNUSED) 
+{
+  mutex_acquire (&mutex);
+  msg ("%s got the mutex.", thread_name ());
+  mutex_release (&mutex);
+}
@@ -0,0 +1,24 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+check_expected ([<<'EOF', <<'EOF']);
+(mutex-stats) begin
+(mutex-stats) Main has priority 34 with 3 waiters.
+(mutex-stats) waiter 2 got the mutex.
+(mutex-stats) waiter 1 got the mutex.
+(mutex-stats) waiter 0 got the mutex.
+(mutex-stats) Try-acquire succeeded.
+(mutex-stats) 5 acquires, 3 contended, 0 won by spinning.
+(mutex-stats) end
+EOF
+(mutex-stats) begin
+(mutex-stats) Main has priority 34 with 3 waiters.
+(mutex-stats) waiter 2 got the mutex.
+(mutex-stats) waiter 1 got the mutex.
+(mutex-stats) waiter 0 got the mutex.
+(mutex-stats) Try-acquire succeeded.
+(mutex-stats) Kernel built without LOCK_PROFILE: no statistics.
+(mutex-stats) end
+EOF
+pass;
@@ -0,0 +1,84 @@
+/* The main thread, at PRI_MIN, acquires lock 0 and creates
+   DEPTH - 1 threads with increasing priorities.  Thread i
+   acquires lock i and then blocks on lock i - 1, held by thread
+   i - 1, so the donation of each new thread has to travel i locks
+   deep to reach the main thread.  That is much deeper than the
+   8 levels that used to be supported.
+
+   When the main thread releases lock 0, the chain unwinds and the
+   threads must finish from the highest priority down. */
+
+#include <stdio.h>
+#include "tests/threads/tests.h"
+#include "threads/init.h"
+#include "threads/synch.h"
+#include "threads/thread.h"
+
+#define DEPTH 32
+
+struct lock_pair
+  {
+    struct lock *own;           /* Lock to hold, or null. */
+    struct lock *wait;          /* Lock to block on. */
+  };
+
+static thread_func donor_thread_func;
+static struct lock locks[DEPTH - 1];
+static struct lock_pair lock_pairs[DEPTH];
+static int finish_order[DEPTH];
+static int finish_cnt;
+
+void
+test_priority_donate_deep (void) 
+{
+  int i;
+
+  /* This test does not work with the MLFQS. */
+  ASSERT (!thread_mlfqs);
+
+  thread_set_priority (PRI_MIN);
+  for (i = 0; i < DEPTH - 1; i++)
+    lock_init (&locks[i]);
+  lock_acquire (&locks[0]);
+  finish_cnt = 0;
+
+  for (i = 1; i < DEPTH; i++)
+    {
+      char name[16];
+      int priority = PRI_MIN + i * 2;
+
+      snprintf (name, sizeof name, "thread %d", i);
+      lock_pairs[i].own = i < DEPTH - 1 ? &locks[i] : NULL;
+      lock_pairs[i].wait = &locks[i - 1];
+      thread_create (name, priority, donor_thread_func, &lock_pairs[i]);
+      if (thread_get_priority () != priority)
+        fail ("main thread should have priority %d after %d donations, "
+              "but has %d", priority, i, thread_get_priority ());
+    }
+  msg ("Main thread received priority %d through %d nested locks.",
+       thread_get_priority (), DEPTH - 1);
+
+  lock_release (&locks[0]);
+  for (i = 0; i < DEPTH - 1; i++)
+    if (finish_order[i] != DEPTH - 1 - i)
+      fail ("thread %d finished in place %d", finish_order[i], i);
+  msg ("Threads finished from highest to lowest priority.");
+  msg ("%s finishing with priority %d.", thread_name (),
+       thread_get_priority ());
+}
+
+static void
+donor_thread_func (void *locks_) 
+{
+  struct lock_pair *locks = locks_;
+
+  if (locks->own != NULL)
+    lock_acquire (locks->own);
+  lock_acquire (locks->wait);
+  lock_release (locks->wait);
+  if (locks->own != NULL)
+    lock_release (locks->own);
+
+  /* Our donations are gone, so this is our own priority. */
+  finish_order[finish_cnt++] = (thread_get_priority () - PRI_MIN) / 2;
+}
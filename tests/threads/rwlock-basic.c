@@ -0,0 +1,105 @@
+/* Exercises the reader-writer lock: try-acquire, writer
+   preference over newly arriving readers, downgrade and upgrade,
+   and priority donation from a waiting writer to the readers and
+   from a waiting reader to the writer.  Also checks that a thread
+   can read-hold several rwlocks at once. */
+
+#include <stdio.h>
+#include "tests/threads/tests.h"
+#include "threads/init.h"
+#include "threads/synch.h"
+#include "threads/thread.h"
+
+#define HOLD_CNT 4
+
+static thread_func writer_thread;
+static thread_func reader_thread;
+static thread_func last_writer_thread;
+static struct rwlock rw;
+static struct rwlock many[HOLD_CNT];
+
+void
+test_rwlock_basic (void) 
+{
+  struct rwlock_hold hold, many_holds[HOLD_CNT];
+  int i;
+
+  /* This test does not work with the MLFQS. */
+  ASSERT (!thread_mlfqs);
+
+  /* Make sure our priority is the default. */
+  ASSERT (thread_get_priority () == PRI_DEFAULT);
+
+  rwlock_init (&rw);
+
+  /* A writer waiting on our read lock donates its priority to us,
+     and holds off readers that arrive after it. */
+  rwlock_read_acquire (&rw, &hold);
+  thread_create ("writer", PRI_DEFAULT + 10, writer_thread, NULL);
+  msg ("Reader has priority %d while a writer waits.",
+       thread_get_priority ());
+  thread_create ("reader", PRI_DEFAULT + 15, reader_thread, NULL);
+  msg ("Reader has priority %d from a reader queued behind the writer.",
+       thread_get_priority ());
+  rwlock_read_release (&rw);
+  msg ("Main has priority %d after release.", thread_get_priority ());
+
+  /* A reader waiting on our write lock donates its priority to
+     us. */
+  rwlock_write_acquire (&rw);
+  thread_create ("reader", PRI_DEFAULT + 10, reader_thread, NULL);
+  msg ("Writer has priority %d while a reader waits.",
+       thread_get_priority ());
+  rwlock_write_release (&rw);
+
+  /* A thread can read-hold any number of rwlocks at once, and a
+     writer waiting on any one of them donates to it. */
+  for (i = 0; i < HOLD_CNT; i++)
+    {
+      rwlock_init (&many[i]);
+      rwlock_read_acquire (&many[i], &many_holds[i]);
+    }
+  thread_create ("writer", PRI_DEFAULT + 5, last_writer_thread, NULL);
+  msg ("Reader of %d rwlocks has priority %d while a writer waits.",
+       HOLD_CNT, thread_get_priority ());
+  for (i = HOLD_CNT - 1; i >= 0; i--)
+    rwlock_read_release (&many[i]);
+  msg ("Main has priority %d after release.", thread_get_priority ());
+}
+
+static void
+writer_thread (void *aux UNUSED) 
+{
+  struct rwlock_hold hold;
+
+  if (!rwlock_write_try_acquire (&rw))
+    msg ("Write try-acquire fails while read-held.");
+  rwlock_write_acquire (&rw);
+  msg ("Writer got the lock.");
+  rwlock_downgrade (&rw, &hold);
+  msg ("Writer downgraded to reader.");
+  if (rwlock_upgrade (&rw))
+    msg ("Reader upgraded to writer.");
+  msg ("Writer done.");
+  rwlock_write_release (&rw);
+}
+
+static void
+reader_thread (void *aux UNUSED) 
+{
+  struct rwlock_hold hold;
+
+  if (!rwlock_read_try_acquire (&rw, &hold))
+    msg ("New reader kept out by a writer.");
+  rwlock_read_acquire (&rw, &hold);
+  msg ("Reader got the lock.");
+  rwlock_read_release (&rw);
+}
+
+static void
+last_writer_thread (void *aux UNUSED) 
+{
+  rwlock_write_acquire (&many[HOLD_CNT - 1]);
+  msg ("Writer got the last rwlock.");
+  rwlock_write_release (&many[HOLD_CNT - 1]);
+}
@@ -0,0 +1,25 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+check_expected ([<<'EOF']);
+(rwlock-basic) begin
+(rwlock-basic) Write try-acquire fails while read-held.
+(rwlock-basic) Reader has priority 41 while a writer waits.
+(rwlock-basic) New reader kept out by a writer.
+(rwlock-basic) Reader has priority 46 from a reader queued behind the writer.
+(rwlock-basic) Writer got the lock.
+(rwlock-basic) Reader got the lock.
+(rwlock-basic) Writer downgraded to reader.
+(rwlock-basic) Reader upgraded to writer.
+(rwlock-basic) Writer done.
+(rwlock-basic) Main has priority 31 after release.
+(rwlock-basic) New reader kept out by a writer.
+(rwlock-basic) Writer has priority 41 while a reader waits.
+(rwlock-basic) Reader got the lock.
+(rwlock-basic) Reader of 4 rwlocks has priority 36 while a writer waits.
+(rwlock-basic) Writer got the last rwlock.
+(rwlock-basic) Main has priority 31 after release.
+(rwlock-basic) end
+EOF
+pass;
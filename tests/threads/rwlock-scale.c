@@ -0,0 +1,83 @@
+/* Measures how read-side critical sections scale with the number
+   of readers.  Each of N readers holds the lock for HOLD_TICKS
+   timer ticks.  Under a reader-writer lock the readers overlap,
+   so the whole round should take about HOLD_TICKS no matter how
+   many readers there are; under a plain lock they serialize and
+   the round takes about N * HOLD_TICKS. */
+
+#include <stdio.h>
+#include "tests/threads/tests.h"
+#include "threads/init.h"
+#include "threads/synch.h"
+#include "threads/thread.h"
+#include "devices/timer.h"
+
+#define HOLD_TICKS 10
+#define READER_MAX 8
+
+static thread_func rwlock_reader;
+static thread_func lock_reader;
+static struct rwlock rw;
+static struct lock mutex;
+static struct semaphore done_sema;
+
+/* Starts N readers running FUNC, waits for all of them, and
+   returns the number of ticks that took. */
+static int64_t
+run_readers (int n, thread_func *func) 
+{
+  int64_t start = timer_ticks ();
+  int i;
+
+  for (i = 0; i < n; i++)
+    {
+      char name[32];
+      snprintf (name, sizeof name, "reader %d", i);
+      thread_create (name, PRI_DEFAULT, func, NULL);
+    }
+  for (i = 0; i < n; i++)
+    sema_down (&done_sema);
+  return timer_elapsed (start);
+}
+
+void
+test_rwlock_scale (void) 
+{
+  int n;
+
+  rwlock_init (&rw);
+  lock_init (&mutex);
+  sema_init (&done_sema, 0);
+
+  for (n = 1; n <= READER_MAX; n *= 2)
+    {
+      int64_t rw_ticks = run_readers (n, rwlock_reader);
+      int64_t lock_ticks = run_readers (n, lock_reader);
+
+      if (rw_ticks >= 2 * HOLD_TICKS)
+        fail ("%d readers took %lld ticks under a rwlock.", n, rw_ticks);
+      msg ("Benchmark: %d readers, rwlock %lld ticks, lock %lld ticks.",
+           n, rw_ticks, lock_ticks);
+    }
+  msg ("Readers overlapped under the rwlock.");
+}
+
+static void
+rwlock_reader (void *aux UNUSED) 
+{
+  struct rwlock_hold hold;
+
+  rwlock_read_acquire (&rw, &hold);
+  timer_sleep (HOLD_TICKS);
+  rwlock_read_release (&rw);
+  sema_up (&done_sema);
+}
+
+static void
+lock_reader (void *aux UNUSED) 
+{
+  lock_acquire (&mutex);
+  timer_sleep (HOLD_TICKS);
+  lock_release (&mutex);
+  sema_up (&done_sema);
+}
@@ -0,0 +1,33 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+
+our ($test);
+my (@output) = read_text_file ("$test.output");
+common_checks ("run", @output);
+
+# Each reader holds the lock for 10 ticks.  Under the rwlock the
+# readers overlap, so a round takes 10 to 19 ticks however many
+# there are; under the plain lock they take turns, so N readers
+# need at least N * 10 ticks.
+foreach my $n (1, 2, 4, 8) {
+    my ($rw, $lock) = map (/^\(rwlock-scale\) Benchmark: $n readers, rwlock (\d+) ticks, lock (\d+) ticks\.$/, @output);
+    fail "missing benchmark results for $n readers\n" if !defined $lock;
+    fail "$n readers took $rw ticks under the rwlock\n"
+      if $rw < 10 || $rw >= 20;
+    fail "$n readers took only $lock ticks under a plain lock\n"
+      if $lock < $n * 10;
+}
+
+s/rwlock \d+ ticks, lock \d+ ticks/rwlock R ticks, lock L ticks/ foreach @output;
+compare_output ("run", \@output, [<<'EOF']);
+(rwlock-scale) begin
+(rwlock-scale) Benchmark: 1 readers, rwlock R ticks, lock L ticks.
+(rwlock-scale) Benchmark: 2 readers, rwlock R ticks, lock L ticks.
+(rwlock-scale) Benchmark: 4 readers, rwlock R ticks, lock L ticks.
+(rwlock-scale) Benchmark: 8 readers, rwlock R ticks, lock L ticks.
+(rwlock-scale) Readers overlapped under the rwlock.
+(rwlock-scale) end
+EOF
+pass;
@@ -0,0 +1,79 @@
+/* Checks ticket transfer under the stride scheduler.  The main
+   thread (100 tickets) holds lock A.  Thread "mid" (200 tickets)
+   takes lock B and then waits for A, lending its tickets to main.
+   Thread "top" (400 tickets) then waits for B, lending its
+   tickets to mid, and through mid to main.  Releasing a lock
+   gives back the tickets lent through it. */
+
+#include <stdio.h>
+#include "tests/threads/tests.h"
+#include "threads/init.h"
+#include "threads/synch.h"
+#include "threads/thread.h"
+#include "devices/timer.h"
+
+static struct lock a, b;
+static struct semaphore done;
+static int mid_tickets_with_a, mid_tickets_after, top_tickets_with_b;
+
+static void
+mid_thread (void *aux UNUSED) 
+{
+  thread_set_tickets (200);
+  lock_acquire (&b);
+  lock_acquire (&a);
+  mid_tickets_with_a = thread_get_tickets ();
+  lock_release (&a);
+  lock_release (&b);
+  mid_tickets_after = thread_get_tickets ();
+  sema_up (&done);
+}
+
+static void
+top_thread (void *aux UNUSED) 
+{
+  thread_set_tickets (400);
+  lock_acquire (&b);
+  top_tickets_with_b = thread_get_tickets ();
+  lock_release (&b);
+  sema_up (&done);
+}
+
+/* Sleeps until the main thread holds EXPECTED tickets, giving up
+   after a second. */
+static void
+wait_for_tickets (int expected) 
+{
+  int i;
+
+  for (i = 0; i < 1000 && thread_get_tickets () != expected; i++)
+    timer_msleep (1);
+  msg ("Main thread has %d tickets.", thread_get_tickets ());
+}
+
+void
+test_stride_donate (void) 
+{
+  /* This test needs the stride scheduler. */
+  ASSERT (thread_stride);
+
+  lock_init (&a);
+  lock_init (&b);
+  sema_init (&done, 0);
+  thread_set_tickets (100);
+  lock_acquire (&a);
+
+  thread_create ("mid", PRI_DEFAULT, mid_thread, NULL);
+  wait_for_tickets (300);
+  thread_create ("top", PRI_DEFAULT, top_thread, NULL);
+  wait_for_tickets (700);
+
+  lock_release (&a);
+  msg ("Main thread has %d tickets after releasing A.",
+       thread_get_tickets ());
+  sema_down (&done);
+  sema_down (&done);
+  msg ("Mid had %d tickets while holding A and B.", mid_tickets_with_a);
+  msg ("Mid had %d tickets after releasing both.", mid_tickets_after);
+  msg ("Top had %d tickets while holding B.", top_tickets_with_b);
+}
@@ -0,0 +1,15 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+check_expected ([<<'EOF']);
+(stride-donate) begin
+(stride-donate) Main thread has 300 tickets.
+(stride-donate) Main thread has 700 tickets.
+(stride-donate) Main thread has 100 tickets after releasing A.
+(stride-donate) Mid had 600 tickets while holding A and B.
+(stride-donate) Mid had 200 tickets after releasing both.
+(stride-donate) Top had 400 tickets while holding B.
+(stride-donate) end
+EOF
+pass;
@@ -0,0 +1,25 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+
+our ($test);
+my (@output) = read_text_file ("$test.output");
+common_checks ("run", @output);
+
+# The threads must get 10%, 20%, 30% and 40% of the CPU, in
+# proportion to their tickets, each within 5% of its target.
+my ($error) = map (/^\(stride-share\) Benchmark: max CPU share error (\d+\.\d\d)% over 4 threads\.$/, @output);
+fail "missing benchmark results\n" if !defined $error;
+fail "a thread's CPU share was off by $error% of its target, more than 5%\n"
+  if $error > 5;
+
+s/error \d+\.\d\d%/error X%/ foreach @output;
+compare_output ("run", \@output, [<<'EOF']);
+(stride-share) begin
+(stride-share) Starting 4 CPU-bound threads with 100 to 400 tickets.
+(stride-share) Every thread got its share of the CPU.
+(stride-share) Benchmark: max CPU share error X% over 4 threads.
+(stride-share) end
+EOF
+pass;
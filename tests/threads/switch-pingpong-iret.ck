@@ -0,0 +1,26 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+
+our ($test);
+my (@output) = read_text_file ("$test.output");
+common_checks ("run", @output);
+
+# This variant is only useful if -iret-switch took effect, so the
+# benchmark must name the iret switch.
+my ($ticks, $rate) = map (/^\(switch-pingpong-iret\) Benchmark \(iret switch\): 200000 switches in (\d+) ticks, (\d+) switches\/s\.$/, @output);
+fail "missing iret switch benchmark results (was -iret-switch ignored?)\n"
+  if !defined $rate;
+fail "200000 switches in $ticks ticks is not $rate switches/s\n"
+  if $ticks == 0 || $rate != int (200000 * 100 / $ticks);
+
+s/in \d+ ticks, \d+ switches/in T ticks, R switches/ foreach @output;
+compare_output ("run", \@output, [<<'EOF']);
+(switch-pingpong-iret) begin
+(switch-pingpong-iret) Bouncing between two threads 100000 times.
+(switch-pingpong-iret) Done.
+(switch-pingpong-iret) Benchmark (iret switch): 200000 switches in T ticks, R switches/s.
+(switch-pingpong-iret) end
+EOF
+pass;
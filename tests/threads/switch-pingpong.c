@@ -0,0 +1,67 @@
+/* Bounces control between two threads through a pair of
+   semaphores, so that every round trip takes two context
+   switches, and reports how many switches per second that
+   achieves.
+
+   The switch-pingpong-iret variant runs the same benchmark with
+   the -iret-switch kernel option, for comparison with the
+   callee-saved-register switch. */
+
+#include <stdio.h>
+#include "tests/threads/tests.h"
+#include "threads/init.h"
+#include "threads/synch.h"
+#include "threads/thread.h"
+#include "devices/timer.h"
+
+#define ROUND_CNT 100000
+
+static thread_func pong_thread;
+static struct semaphore ping_sema;
+static struct semaphore pong_sema;
+static struct semaphore done_sema;
+
+void
+test_switch_pingpong (void) 
+{
+  int64_t start, elapsed;
+  long long switches;
+  int i;
+
+  msg ("Bouncing between two threads %d times.", ROUND_CNT);
+
+  sema_init (&ping_sema, 0);
+  sema_init (&pong_sema, 0);
+  sema_init (&done_sema, 0);
+  thread_create ("pong", thread_get_priority (), pong_thread, NULL);
+
+  start = timer_ticks ();
+  for (i = 0; i < ROUND_CNT; i++) 
+    {
+      sema_up (&ping_sema);
+      sema_down (&pong_sema);
+    }
+  elapsed = timer_elapsed (start);
+  sema_down (&done_sema);
+
+  msg ("Done.");
+  switches = 2LL * ROUND_CNT;
+  if (elapsed == 0)
+    elapsed = 1;
+  msg ("Benchmark (%s switch): %lld switches in %lld ticks, %lld switches/s.",
+       thread_iret_switch ? "iret" : "fast", switches, elapsed,
+       switches * TIMER_FREQ / elapsed);
+}
+
+static void
+pong_thread (void *aux UNUSED) 
+{
+  int i;
+
+  for (i = 0; i < ROUND_CNT; i++) 
+    {
+      sema_down (&ping_sema);
+      sema_up (&pong_sema);
+    }
+  sema_up (&done_sema);
+}
@@ -0,0 +1,25 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+
+our ($test);
+my (@output) = read_text_file ("$test.output");
+common_checks ("run", @output);
+
+# Without -iret-switch the benchmark must have used the fast
+# switch, and its rate must follow from its tick count.
+my ($ticks, $rate) = map (/^\(switch-pingpong\) Benchmark \(fast switch\): 200000 switches in (\d+) ticks, (\d+) switches\/s\.$/, @output);
+fail "missing fast switch benchmark results\n" if !defined $rate;
+fail "200000 switches in $ticks ticks is not $rate switches/s\n"
+  if $ticks == 0 || $rate != int (200000 * 100 / $ticks);
+
+s/in \d+ ticks, \d+ switches/in T ticks, R switches/ foreach @output;
+compare_output ("run", \@output, [<<'EOF']);
+(switch-pingpong) begin
+(switch-pingpong) Bouncing between two threads 100000 times.
+(switch-pingpong) Done.
+(switch-pingpong) Benchmark (fast switch): 200000 switches in T ticks, R switches/s.
+(switch-pingpong) end
+EOF
+pass;
@@ -17,6 +17,22 @@ static const struct test tests[] =
     {"alarm-priority", test_alarm_priority},
     {"alarm-zero", test_alarm_zero},
     {"alarm-negative", test_alarm_negative},
+    {"alarm-stress", test_alarm_stress},
+    {"alarm-many", test_alarm_many},
+    {"fair-share", test_fair_share},
+    {"edf-periodic", test_edf_periodic},
+    {"switch-pingpong", test_switch_pingpong},
+    {"switch-pingpong-iret", test_switch_pingpong},
+    {"rwlock-basic", test_rwlock_basic},
+    {"rwlock-scale", test_rwlock_scale},
+    {"condvar-pc", test_condvar_pc},
+    {"mutex-stats", test_mutex_stats},
+    {"intr-off", test_intr_off},
+    {"workqueue", test_workqueue},
+    {"create-exit", test_create_exit},
+    {"hrtimer-sleep", test_hrtimer_sleep},
+    {"stride-share", test_stride_share},
+    {"stride-donate", test_stride_donate},
     {"priority-change", test_priority_change},
     {"priority-donate-one", test_priority_donate_one},
     {"priority-donate-multiple", test_priority_donate_multiple},
@@ -25,19 +41,20 @@ static const struct test tests[] =
     {"priority-donate-sema", test_priority_donate_sema},
     {"priority-donate-lower", test_priority_donate_lower},
     {"priority-donate-chain", test_priority_donate_chain},
+    {"priority-donate-deep", test_priority_donate_deep},
     {"priority-fifo", test_priority_fifo},
     {"priority-preempt", test_priority_preempt},
     {"priority-sema", test_priority_sema},
     {"priority-condvar", test_priority_condvar},
-    // {"mlfqs-load-1", test_mlfqs_load_1},
-    // {"mlfqs-load-60", test_mlfqs_load_60},
-    // {"mlfqs-load-avg", test_mlfqs_load_avg},
-    // {"mlfqs-recent-1", test_mlfqs_recent_1},
-    // {"mlfqs-fair-2", test_mlfqs_fair_2},
-    // {"mlfqs-fair-20", test_mlfqs_fair_20},
-    // {"mlfqs-nice-2", test_mlfqs_nice_2},
-    // {"mlfqs-nice-10", test_mlfqs_nice_10},
-    // {"mlfqs-block", test_mlfqs_block},
+    {"mlfqs-load-1", test_mlfqs_load_1},
+    {"mlfqs-load-60", test_mlfqs_load_60},
+    {"mlfqs-load-avg", test_mlfqs_load_avg},
+    {"mlfqs-recent-1", test_mlfqs_recent_1},
+    {"mlfqs-fair-2", test_mlfqs_fair_2},
+    {"mlfqs-fair-20", test_mlfqs_fair_20},
+    {"mlfqs-nice-2", test_mlfqs_nice_2},
+    {"mlfqs-nice-10", test_mlfqs_nice_10},
+    {"mlfqs-block", test_mlfqs_block},
   };
 
 static const char *test_name;
@@ -11,6 +11,21 @@ extern test_func test_alarm_simultaneous;
 extern test_func test_alarm_priority;
 extern test_func test_alarm_zero;
 extern test_func test_alarm_negative;
+extern test_func test_alarm_stress;
+extern test_func test_alarm_many;
+extern test_func test_fair_share;
+extern test_func test_edf_periodic;
+extern test_func test_switch_pingpong;
+extern test_func test_rwlock_basic;
+extern test_func test_rwlock_scale;
+extern test_func test_condvar_pc;
+extern test_func test_mutex_stats;
+extern test_func test_intr_off;
+extern test_func test_workqueue;
+extern test_func test_create_exit;
+extern test_func test_hrtimer_sleep;
+extern test_func test_stride_share;
+extern test_func test_stride_donate;
 extern test_func test_priority_change;
 extern test_func test_priority_donate_one;
 extern test_func test_priority_donate_multiple;
@@ -19,6 +34,7 @@ extern test_func test_priority_donate_sema;
 extern test_func test_priority_donate_nest;
 extern test_func test_priority_donate_lower;
 extern test_func test_priority_donate_chain;
+extern test_func test_priority_donate_deep;
 extern test_func test_priority_fifo;
 extern test_func test_priority_preempt;
 extern test_func test_priority_sema;
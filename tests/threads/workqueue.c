@@ -0,0 +1,81 @@
+/* Exercises workqueues: a batch of work items run on a pool of
+   workers, an already-pending item is not queued twice, delayed
+   work waits for its delay, and flush_workqueue() waits for
+   everything queued before it. */
+
+#include <stdio.h>
+#include "tests/threads/tests.h"
+#include "threads/init.h"
+#include "threads/synch.h"
+#include "threads/thread.h"
+#include "threads/workqueue.h"
+#include "devices/timer.h"
+
+#define WORK_CNT 64
+#define DELAY_TICKS 20
+
+struct counted_work 
+  {
+    struct work work;
+    int runs;
+  };
+
+static struct counted_work works[WORK_CNT];
+static struct work delayed;
+static int64_t delayed_queued_at;
+static int64_t delayed_ran_at;
+
+static void
+count_work (struct work *work) 
+{
+  struct counted_work *cw = (struct counted_work *) work;
+
+  /* Give the other workers a chance to run too. */
+  thread_yield ();
+  cw->runs++;
+}
+
+static void
+delayed_work (struct work *work UNUSED) 
+{
+  delayed_ran_at = timer_ticks ();
+}
+
+void
+test_workqueue (void) 
+{
+  struct workqueue *wq;
+  int i, runs = 0;
+
+  /* Below our priority, so nothing runs until we flush. */
+  wq = workqueue_create ("test-wq", 4, PRI_DEFAULT - 1);
+  ASSERT (wq != NULL);
+
+  msg ("Queuing %d work items on 4 workers.", WORK_CNT);
+  for (i = 0; i < WORK_CNT; i++) 
+    {
+      work_init (&works[i].work, count_work);
+      works[i].runs = 0;
+      if (!queue_work (wq, &works[i].work))
+        fail ("Work item %d was not queued.", i);
+    }
+  if (queue_work (wq, &works[WORK_CNT - 1].work))
+    fail ("Pending work item was queued twice.");
+  flush_workqueue (wq);
+  for (i = 0; i < WORK_CNT; i++)
+    runs += works[i].runs;
+  msg ("Flush returned after %d runs.", runs);
+
+  msg ("Queuing delayed work for %d ticks.", DELAY_TICKS);
+  work_init (&delayed, delayed_work);
+  delayed_queued_at = timer_ticks ();
+  queue_delayed_work (wq, &delayed, DELAY_TICKS);
+  timer_sleep (DELAY_TICKS * 2);
+  flush_workqueue (wq);
+  if (delayed_ran_at == 0)
+    fail ("Delayed work never ran.");
+  if (delayed_ran_at - delayed_queued_at < DELAY_TICKS)
+    fail ("Delayed work ran after only %lld ticks.",
+          delayed_ran_at - delayed_queued_at);
+  msg ("Delayed work ran after its delay.");
+}
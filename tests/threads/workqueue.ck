@@ -0,0 +1,13 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+check_expected ([<<'EOF']);
+(workqueue) begin
+(workqueue) Queuing 64 work items on 4 workers.
+(workqueue) Flush returned after 64 runs.
+(workqueue) Queuing delayed work for 20 ticks.
+(workqueue) Delayed work ran after its delay.
+(workqueue) end
+EOF
+pass;
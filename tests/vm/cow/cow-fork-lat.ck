@@ -0,0 +1,40 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+
+our ($test);
+my (@output) = read_text_file ("$test.output");
+common_checks ("run", @output);
+
+# Every fork copies the same supplemental page table, since BUF is
+# in the page table whether or not it is resident, so with
+# copy-on-write the resident pages only add a cheap per-page share.
+# An eager copy adds a 4 kB page allocation and memcpy for each of
+# the 508 extra resident pages, which outweighs the rest of fork,
+# so it cannot stay within a small factor of the 16 kB fork.
+my ($factor) = 4;
+my (%kcycles) = map (/^\(cow-fork-lat\) Benchmark: fork with (\d+) kB resident took (\d+) kcycles\.$/, @output);
+foreach my $kb (16, 128, 512, 2048) {
+    fail "missing benchmark result for $kb kB\n" if !defined $kcycles{$kb};
+}
+fail "fork with 2048 kB resident took $kcycles{2048} kcycles, "
+  . "more than $factor times the $kcycles{16} with 16 kB: not copy-on-write\n"
+  if $kcycles{2048} > $factor * ($kcycles{16} || 1);
+
+s/took \d+ kcycles/took K kcycles/ foreach @output;
+compare_output ("run", IGNORE_EXIT_CODES => 1, \@output, [<<'EOF']);
+(cow-fork-lat) begin
+(cow-fork-lat) fork
+(cow-fork-lat) Benchmark: fork with 16 kB resident took K kcycles.
+(cow-fork-lat) fork
+(cow-fork-lat) Benchmark: fork with 128 kB resident took K kcycles.
+(cow-fork-lat) fork
+(cow-fork-lat) Benchmark: fork with 512 kB resident took K kcycles.
+(cow-fork-lat) fork
+(cow-fork-lat) Benchmark: fork with 2048 kB resident took K kcycles.
+(cow-fork-lat) fork
+(cow-fork-lat) Child's writes to 512 shared pages stayed private.
+(cow-fork-lat) end
+EOF
+pass;
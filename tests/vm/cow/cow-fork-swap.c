@@ -0,0 +1,57 @@
+/* Forks while most of the parent's pages are swapped out.  The
+   parent writes more pages than fit in the 10 MB of memory this
+   test runs with, so that fork has to share swap slots as well as
+   resident frames.  The child then checks and overwrites every
+   page, and the parent checks that its own pages are unchanged. */
+
+#include <string.h>
+#include <syscall.h>
+#include "tests/lib.h"
+#include "tests/main.h"
+
+#define PAGE_SIZE 4096
+#define PAGE_CNT 4096
+
+static char buf[PAGE_CNT * PAGE_SIZE];
+
+/* Child side: every page must still hold what the parent wrote,
+   and must read back what the child writes. */
+static int
+child_write (void)
+{
+  int i;
+
+  for (i = 0; i < PAGE_CNT; i++)
+    {
+      if (buf[i * PAGE_SIZE] != (char) i)
+        return 1;
+      buf[i * PAGE_SIZE] = (char) ~i;
+    }
+  for (i = 0; i < PAGE_CNT; i++)
+    if (buf[i * PAGE_SIZE] != (char) ~i)
+      return 1;
+  return 0;
+}
+
+void
+test_main (void)
+{
+  pid_t child;
+  int i;
+
+  msg ("write %d pages", PAGE_CNT);
+  for (i = 0; i < PAGE_CNT; i++)
+    buf[i * PAGE_SIZE] = i;
+
+  child = fork ("cow-fork-swap");
+  if (child == 0)
+    exit (child_write ());
+  CHECK (child > 0, "fork");
+  if (wait (child) != 0)
+    fail ("child saw the wrong data");
+
+  for (i = 0; i < PAGE_CNT; i++)
+    if (buf[i * PAGE_SIZE] != (char) i)
+      fail ("child's write to page %d showed up in the parent", i);
+  msg ("parent's %d pages unchanged", PAGE_CNT);
+}
@@ -0,0 +1,12 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+check_expected (IGNORE_EXIT_CODES => 1, [<<'EOF']);
+(cow-fork-swap) begin
+(cow-fork-swap) write 4096 pages
+(cow-fork-swap) fork
+(cow-fork-swap) parent's 4096 pages unchanged
+(cow-fork-swap) end
+EOF
+pass;
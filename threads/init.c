@@ -19,8 +19,10 @@
 #include "threads/malloc.h"
 #include "threads/mmu.h"
 #include "threads/palloc.h"
+#include "threads/profile.h"
 #include "threads/pte.h"
 #include "threads/thread.h"
+#include "threads/workqueue.h"
 #ifdef USERPROG
 #include "userprog/process.h"
 #include "userprog/exception.h"
@@ -86,6 +88,7 @@ main (void) {
 	mem_end = palloc_init ();
 	malloc_init ();
 	paging_init (mem_end);
+	workqueue_init ();
 
 #ifdef USERPROG
 	tss_init ();
@@ -222,15 +225,35 @@ parse_options (char **argv) {
 			random_init (atoi (value));
 		else if (!strcmp (name, "-mlfqs"))
 			thread_mlfqs = true;
+		else if (!strcmp (name, "-fair"))
+			thread_fair = true;
+		else if (!strcmp (name, "-stride"))
+			thread_stride = true;
+		else if (!strcmp (name, "-iret-switch"))
+			thread_iret_switch = true;
+		else if (!strcmp (name, "-nohz"))
+			timer_nohz = true;
+		else if (!strcmp (name, "-sched-trace"))
+			thread_trace = true;
+#ifdef CPU_PROFILE
+		else if (!strcmp (name, "-profile-depth"))
+			profile_depth = atoi (value);
+#endif
 #ifdef USERPROG
 		else if (!strcmp (name, "-ul"))
 			user_page_limit = atoi (value);
 		else if (!strcmp (name, "-threads-tests"))
 			thread_tests = true;
+#endif
+#ifdef VM
+		else if (!strcmp (name, "-vm-clock"))
+			vm_clock = true;
 #endif
 		else
 			PANIC ("unknown option `%s' (use -h for help)", name);
 	}
+	if (thread_mlfqs + thread_fair + thread_stride > 1)
+		PANIC ("only one of -mlfqs, -fair and -stride may be used");
 
 	return argv;
 }
@@ -328,8 +351,19 @@ usage (void) {
 			"  -f                 Format file system disk during startup.\n"
 			"  -rs=SEED           Set random number seed to SEED.\n"
 			"  -mlfqs             Use multi-level feedback queue scheduler.\n"
+			"  -fair              Use proportional-share scheduler.\n"
+			"  -stride            Use stride scheduler with ticket transfer.\n"
+			"  -iret-switch       Switch threads through intr_frame and iretq.\n"
+			"  -nohz              Stop the timer tick while the CPU is idle.\n"
+			"  -sched-trace       Dump scheduler events to the console at shutdown.\n"
+#ifdef CPU_PROFILE
+			"  -profile-depth=N   Record N stack frames per profiler sample.\n"
+#endif
 #ifdef USERPROG
 			"  -ul=COUNT          Limit user memory to COUNT pages.\n"
+#endif
+#ifdef VM
+			"  -vm-clock          Use single-list clock page replacement.\n"
 #endif
 			);
 	power_off ();
@@ -344,6 +378,7 @@ power_off (void) {
 	filesys_done ();
 #endif
 
+	thread_trace_dump ();
 	print_stats ();
 
 	printf ("Powering off...\n");
@@ -356,6 +391,16 @@ static void
 print_stats (void) {
 	timer_print_stats ();
 	thread_print_stats ();
+#ifdef LOCK_PROFILE
+	mutex_print_stats ();
+	lock_print_stats ();
+#endif
+#ifdef INTR_PROFILE
+	intr_print_stats ();
+#endif
+#ifdef CPU_PROFILE
+	profile_print_stats ();
+#endif
 #ifdef FILESYS
 	disk_print_stats ();
 #endif
@@ -364,4 +409,7 @@ print_stats (void) {
 #ifdef USERPROG
 	exception_print_stats ();
 #endif
+#ifdef VM
+	vm_print_stats ();
+#endif
 }
@@ -103,6 +103,34 @@ static const char *intr_names[INTR_CNT];
 static bool in_external_intr;   /* Are we processing an external interrupt? */
 static bool yield_on_return;    /* Should we yield on interrupt return? */
 
+/* Softirqs, or bottom halves.  An external interrupt handler (the
+   top half) does only what must be done with interrupts off, such
+   as acknowledging the device, and calls raise_softirq() to defer
+   the rest.  Once the top half returns and the PIC has been
+   acknowledged, intr_handler() runs the pending bottom halves with
+   interrupts enabled, and only then honors yield_on_return.
+   Another interrupt arriving meanwhile runs its top half and
+   returns, leaving its bottom halves to the loop already running.
+   Bottom halves count as interrupt context: they may not sleep. */
+static softirq_func *softirq_handlers[SOFTIRQ_CNT];
+static unsigned softirq_pending; /* Bitmap of raised softirqs. */
+static bool in_softirq;          /* Are we running bottom halves? */
+
+static void do_softirq (void);
+
+#ifdef INTR_PROFILE
+/* Interrupt-off time profiling, in TSC cycles. */
+static uint64_t intr_off_start;         /* Start of current off window, or 0. */
+static void *intr_off_site;             /* Where the current window began. */
+static uint64_t intr_off_max;           /* Longest off window. */
+static void *intr_off_max_begin;        /* Where it began. */
+static void *intr_off_max_end;          /* Where it ended. */
+static long long softirq_cnt[SOFTIRQ_CNT]; /* # of times each softirq ran. */
+
+static void intr_off_begin (void *site);
+static void intr_off_end (void *site);
+#endif
+
 /* Programmable Interrupt Controller helpers. */
 static void pic_init (void);
 static void pic_end_of_interrupt (int irq);
@@ -131,11 +159,17 @@ intr_set_level (enum intr_level level) {
 	return level == INTR_ON ? intr_enable () : intr_disable ();
 }
 
-/* Enables interrupts and returns the previous interrupt status. */
+/* Enables interrupts and returns the previous interrupt status.
+   Bottom halves may enable interrupts, but top halves may not. */
 enum intr_level
 intr_enable (void) {
 	enum intr_level old_level = intr_get_level ();
-	ASSERT (!intr_context ());
+	ASSERT (!in_external_intr);
+
+#ifdef INTR_PROFILE
+	if (old_level == INTR_OFF)
+		intr_off_end (__builtin_return_address (0));
+#endif
 
 	/* Enable interrupts by setting the interrupt flag.
 
@@ -156,6 +190,11 @@ intr_disable (void) {
 	   Hardware Interrupts". */
 	asm volatile ("cli" : : : "memory");
 
+#ifdef INTR_PROFILE
+	if (old_level == INTR_ON)
+		intr_off_begin (__builtin_return_address (0));
+#endif
+
 	return old_level;
 }
 
@@ -252,11 +291,58 @@ intr_register_int (uint8_t vec_no, int dpl, enum intr_level level,
 	register_handler (vec_no, dpl, level, handler, name);
 }
 
-/* Returns true during processing of an external interrupt
-   and false at all other times. */
+/* Returns true during processing of an external interrupt,
+   including its bottom halves, and false at all other times. */
 bool
 intr_context (void) {
-	return in_external_intr;
+	return in_external_intr || in_softirq;
+}
+
+/* Sets HANDLER as the bottom half for softirq NR. */
+void
+softirq_register (enum softirq nr, softirq_func *handler) {
+	ASSERT (nr < SOFTIRQ_CNT);
+	ASSERT (softirq_handlers[nr] == NULL);
+
+	softirq_handlers[nr] = handler;
+}
+
+/* Marks softirq NR pending, so that its bottom half runs when the
+   current external interrupt returns.  Must be called from an
+   external interrupt handler. */
+void
+raise_softirq (enum softirq nr) {
+	ASSERT (nr < SOFTIRQ_CNT);
+	ASSERT (intr_get_level () == INTR_OFF);
+	ASSERT (intr_context ());
+
+	softirq_pending |= 1u << nr;
+}
+
+/* Runs pending bottom halves with interrupts on, until none are
+   left.  Called with interrupts off at the end of an external
+   interrupt, and returns with them off again. */
+static void
+do_softirq (void) {
+	ASSERT (intr_get_level () == INTR_OFF);
+	ASSERT (!in_softirq);
+
+	in_softirq = true;
+	while (softirq_pending != 0) {
+		unsigned pending = softirq_pending;
+		softirq_pending = 0;
+
+		intr_enable ();
+		for (int nr = 0; nr < SOFTIRQ_CNT; nr++)
+			if (pending & (1u << nr)) {
+#ifdef INTR_PROFILE
+				softirq_cnt[nr]++;
+#endif
+				softirq_handlers[nr] ();
+			}
+		intr_disable ();
+	}
+	in_softirq = false;
 }
 
 /* During processing of an external interrupt, directs the
@@ -340,10 +426,16 @@ intr_handler (struct intr_frame *frame) {
 	external = frame->vec_no >= 0x20 && frame->vec_no < 0x30;
 	if (external) {
 		ASSERT (intr_get_level () == INTR_OFF);
-		ASSERT (!intr_context ());
+		ASSERT (!in_external_intr);
 
+#ifdef INTR_PROFILE
+		if (frame->eflags & FLAG_IF)
+			intr_off_begin ((void *) frame->rip);
+#endif
 		in_external_intr = true;
-		yield_on_return = false;
+		// bottom half 도중에 들어온 interrupt라면 바깥의 yield 요청을 유지
+		if (!in_softirq)
+			yield_on_return = false;
 	}
 
 	/* Invoke the interrupt's handler. */
@@ -369,11 +461,74 @@ intr_handler (struct intr_frame *frame) {
 		in_external_intr = false;
 		pic_end_of_interrupt (frame->vec_no);
 
-		if (yield_on_return)
-			thread_yield ();
+		// bottom half 도중이었다면 softirq와 yield는 바깥 interrupt가 처리
+		if (!in_softirq) {
+			if (softirq_pending != 0)
+				do_softirq ();
+			if (yield_on_return)
+				thread_yield ();
+		}
+#ifdef INTR_PROFILE
+		// iretq로 interrupt가 다시 켜지는 시점
+		if (frame->eflags & FLAG_IF)
+			intr_off_end ((void *) frame->rip);
+#endif
+	}
+}
+
+#ifdef INTR_PROFILE
+/* Notes that interrupts were turned off at SITE. */
+static void
+intr_off_begin (void *site) {
+	intr_off_start = rdtsc ();
+	intr_off_site = site;
+}
+
+/* Notes that interrupts are being turned on at SITE, and records
+   the window if it is the longest so far. */
+static void
+intr_off_end (void *site) {
+	if (intr_off_start != 0) {
+		uint64_t off = rdtsc () - intr_off_start;
+		if (off > intr_off_max) {
+			intr_off_max = off;
+			intr_off_max_begin = intr_off_site;
+			intr_off_max_end = site;
+		}
+		intr_off_start = 0;
 	}
 }
 
+/* Prints the longest interrupt-off window and softirq counts.
+   The addresses can be turned into function names with the
+   `backtrace' utility. */
+void
+intr_print_stats (void) {
+	printf ("Interrupts: longest off window %"PRIu64" cycles, from %p to %p\n",
+			intr_off_max, intr_off_max_begin, intr_off_max_end);
+	printf ("Softirqs: %lld timer, %lld disk\n",
+			softirq_cnt[SOFTIRQ_TIMER], softirq_cnt[SOFTIRQ_DISK]);
+}
+
+/* Forgets the longest interrupt-off window seen so far, so that a
+   test can measure only the windows of the load it generates. */
+void
+intr_reset_stats (void) {
+	enum intr_level old_level = intr_disable ();
+
+	intr_off_max = 0;
+	intr_off_max_begin = intr_off_max_end = NULL;
+	intr_set_level (old_level);
+}
+
+/* Returns the length of the longest interrupt-off window, in TSC
+   cycles, since boot or the last intr_reset_stats(). */
+uint64_t
+intr_off_max_cycles (void) {
+	return intr_off_max;
+}
+#endif /* INTR_PROFILE */
+
 /* Dumps interrupt frame F to the console, for debugging. */
 void
 intr_dump_frame (const struct intr_frame *f) {
@@ -0,0 +1,161 @@
+#include "threads/profile.h"
+#ifdef CPU_PROFILE
+#include <debug.h>
+#include <stdio.h>
+#include <string.h>
+#include "threads/thread.h"
+#include "threads/vaddr.h"
+#ifdef USERPROG
+#include "threads/mmu.h"
+#endif
+
+/* Sampling CPU profiler.
+
+   Build with `make CPU_PROFILE=1'.  At every timer tick,
+   timer_interrupt() passes the interrupted frame to
+   profile_sample(), which counts the interrupted rip, together
+   with the running thread and whether it was in user mode, in a
+   histogram.  With -profile-depth=N the first N-1 callers are
+   added to the key by following saved frame pointers, which the
+   kernel always keeps (-fno-omit-frame-pointer).
+
+   The histogram is printed at shutdown, one line per distinct
+   stack; `backtrace --profile' turns it into a flat profile and
+   folded stacks for flame graphs. */
+
+/* A distinct (thread, mode, stack) and its number of samples. */
+struct profile_entry {
+	long long samples;          /* 0 if the slot is free. */
+	tid_t tid;                  /* Thread that was running. */
+	uint8_t user;               /* Interrupted in user mode? */
+	uint8_t depth;              /* # of entries in PCS. */
+	uintptr_t pcs[PROFILE_DEPTH_MAX];   /* Interrupted rip, then callers. */
+};
+
+#define PROFILE_SLOTS 1024      /* Must be a power of 2. */
+static struct profile_entry profile_table[PROFILE_SLOTS];
+static long long profile_samples;   /* # of samples taken. */
+static long long profile_dropped;   /* # of samples lost to a full table. */
+
+int profile_depth = 1;
+
+static int walk_stack (const struct intr_frame *, bool user, uintptr_t *pcs);
+static bool read_frame (uintptr_t rbp, bool user, uintptr_t frame[2]);
+
+/* Records one sample of the interrupted context F.  Called by the
+   timer interrupt handler. */
+void
+profile_sample (const struct intr_frame *f) {
+	struct profile_entry e;
+	uint64_t hash;
+	size_t i;
+
+	ASSERT (intr_context ());
+
+	memset (&e, 0, sizeof e);
+	e.tid = thread_current ()->tid;
+	e.user = (f->cs & 3) == 3;
+	e.depth = walk_stack (f, e.user, e.pcs);
+
+	// (tid, mode, stack)의 hash로 시작 위치를 정하고 선형 탐색
+	hash = ((uint64_t) e.tid << 1 | e.user) * 0x9e3779b97f4a7c15ULL;
+	for (int d = 0; d < e.depth; d++)
+		hash = (hash ^ e.pcs[d]) * 0x9e3779b97f4a7c15ULL;
+	hash >>= 32;
+
+	profile_samples++;
+	for (i = 0; i < PROFILE_SLOTS; i++) {
+		struct profile_entry *p = &profile_table[(hash + i) % PROFILE_SLOTS];
+		if (p->samples == 0) {
+			*p = e;
+			p->samples = 1;
+			return;
+		}
+		if (p->tid == e.tid && p->user == e.user && p->depth == e.depth
+				&& !memcmp (p->pcs, e.pcs, e.depth * sizeof e.pcs[0])) {
+			p->samples++;
+			return;
+		}
+	}
+	profile_dropped++;
+}
+
+/* Prints every histogram entry as a `profile:' line: samples,
+   tid, `k' or `u', then the interrupted rip and its callers.
+   Pass the output to `backtrace --profile'. */
+void
+profile_print_stats (void) {
+	printf ("profile: begin %lld samples, %lld dropped, depth %d\n",
+			profile_samples, profile_dropped, profile_depth);
+	for (size_t i = 0; i < PROFILE_SLOTS; i++) {
+		struct profile_entry *p = &profile_table[i];
+		if (p->samples == 0)
+			continue;
+		printf ("profile: %lld %d %c", p->samples, p->tid, p->user ? 'u' : 'k');
+		for (int d = 0; d < p->depth; d++)
+			printf (" %#llx", (unsigned long long) p->pcs[d]);
+		printf ("\n");
+	}
+	printf ("profile: end\n");
+}
+
+/* Stores the interrupted rip of F and up to profile_depth - 1 of
+   its callers into PCS.  Returns the number stored. */
+static int
+walk_stack (const struct intr_frame *f, bool user, uintptr_t *pcs) {
+	uintptr_t rbp = f->R.rbp;
+	int depth = profile_depth;
+	int n = 0;
+
+	if (depth < 1)
+		depth = 1;
+	if (depth > PROFILE_DEPTH_MAX)
+		depth = PROFILE_DEPTH_MAX;
+
+	pcs[n++] = f->rip;
+	while (n < depth) {
+		uintptr_t frame[2];     /* Saved rbp, return address. */
+
+		if (!read_frame (rbp, user, frame) || frame[1] == 0)
+			break;
+		pcs[n++] = frame[1];
+		// frame은 stack의 위쪽(높은 주소)으로만 이어져야 함
+		if (frame[0] <= rbp)
+			break;
+		rbp = frame[0];
+	}
+	return n;
+}
+
+/* Reads the saved rbp and return address at RBP into FRAME,
+   returning false if RBP is not a plausible frame pointer.
+   Never faults: kernel frames must lie on the running thread's
+   stack page, and user frames on a present user page. */
+static bool
+read_frame (uintptr_t rbp, bool user, uintptr_t frame[2]) {
+	const uintptr_t *p;
+
+	if (rbp % sizeof (uintptr_t) != 0 || pg_ofs (rbp) > PGSIZE - sizeof frame[0] * 2)
+		return false;
+
+	if (!user) {
+		if (pg_round_down (rbp) != pg_round_down (thread_current ()))
+			return false;
+		p = (const uintptr_t *) rbp;
+	} else {
+#ifdef USERPROG
+		struct thread *t = thread_current ();
+		if (t->pml4 == NULL || !is_user_vaddr (rbp))
+			return false;
+		p = pml4_get_page (t->pml4, (void *) rbp);
+		if (p == NULL)
+			return false;
+#else
+		return false;
+#endif
+	}
+	frame[0] = p[0];
+	frame[1] = p[1];
+	return true;
+}
+#endif /* CPU_PROFILE */
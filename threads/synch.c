@@ -31,6 +31,7 @@
 #include <string.h>
 #include "threads/interrupt.h"
 #include "threads/thread.h"
+#include "intrinsic.h"
 
 /* Initializes semaphore SEMA to VALUE.  A semaphore is a
    nonnegative integer along with two atomic operators for
@@ -124,6 +125,14 @@ sema_up (struct semaphore *sema) {
 }
 
 static void sema_test_helper (void *sema_);
+static bool donor_less (const struct rb_elem *, const struct rb_elem *, void *);
+#ifdef LOCK_PROFILE
+static void lock_prof_acquired (struct lock *, void *site, bool contended,
+		uint64_t start);
+static void lock_prof_released (struct lock *);
+#endif
+static bool cond_waiter_less (const struct rb_elem *, const struct rb_elem *,
+		void *);
 
 /* Self-test for semaphores that makes control "ping-pong"
    between a pair of threads.  Insert calls to printf() to see
@@ -179,6 +188,21 @@ lock_init (struct lock *lock) {
 
 	lock->holder = NULL;
 	sema_init (&lock->semaphore, 1);
+	rb_init (&lock->donors, donor_less, NULL);
+	lock->priority = PRI_MIN;
+	lock->tickets = 0;
+#ifdef LOCK_PROFILE
+	lock->prof_site = NULL;
+	lock->prof_acquired = 0;
+#endif
+}
+
+/* lock의 donors 정렬 기준: priority가 높은 thread가 앞 (같으면 먼저 기다린 thread가 앞) */
+static bool
+donor_less (const struct rb_elem *a, const struct rb_elem *b,
+		void *aux UNUSED) {
+	return rb_entry (a, struct thread, donor_elem)->priority
+			> rb_entry (b, struct thread, donor_elem)->priority;
 }
 
 /* Acquires LOCK, sleeping until it becomes available if
@@ -195,22 +219,37 @@ lock_acquire (struct lock *lock) {
 	ASSERT (!intr_context ());
 	ASSERT (!lock_held_by_current_thread (lock));
 
+#ifdef LOCK_PROFILE
+	void *site = __builtin_return_address (0);
+	uint64_t start = rdtsc ();
+	bool contended = lock->holder != NULL;
+#endif
+
 	// lock 획득 전, 누군가 lock을 가지고 있다면 priority를 양도
 	struct thread *curr = thread_current ();
-	if (lock->holder) {
+	enum intr_level old_level = intr_disable ();
+	// MLFQS에서는 priority donation을 하지 않음
+	if (lock->holder && !thread_mlfqs) {
 		// 우선순위를 양도하는 목적인 lock을 기록
 		curr->wait_on_lock = lock;
-		// 우선순위를 양도하는 thread의 donations에 current thread를 연결
-		list_insert_ordered (&lock->holder->donations, &curr->donation_elem, thread_compare_donate_priority, 0);
+		// lock의 donors에 current thread를 추가 (O(log n))
+		rb_insert (&lock->donors, &curr->donor_elem);
 		// 우선순위를 양도
 		donate_priority ();
 	}
+	intr_set_level (old_level);
 	// lock 획득 요청
 	sema_down (&lock->semaphore);
 
-	// lock 획득 후, wait_on_lock 초기화
-	curr->wait_on_lock = NULL;
+	// lock 획득 후, donors에서 빠지고 남은 donors의 donation을 이어받음
+	old_level = intr_disable ();
 	lock->holder = curr;
+	if (!thread_mlfqs)
+		add_held_lock (lock);
+#ifdef LOCK_PROFILE
+	lock_prof_acquired (lock, site, contended, start);
+#endif
+	intr_set_level (old_level);
 }
 
 /* Tries to acquires LOCK and returns true if successful or false
@@ -227,8 +266,16 @@ lock_try_acquire (struct lock *lock) {
 	ASSERT (!lock_held_by_current_thread (lock));
 
 	success = sema_try_down (&lock->semaphore);
-	if (success)
+	if (success) {
+		enum intr_level old_level = intr_disable ();
 		lock->holder = thread_current ();
+		if (!thread_mlfqs)
+			add_held_lock (lock);
+#ifdef LOCK_PROFILE
+		lock_prof_acquired (lock, __builtin_return_address (0), false, 0);
+#endif
+		intr_set_level (old_level);
+	}
 	return success;
 }
 
@@ -243,10 +290,17 @@ lock_release (struct lock *lock) {
 	ASSERT (lock != NULL);
 	ASSERT (lock_held_by_current_thread (lock));
 
-	remove_with_lock (lock);
-	refresh_priority ();
+	enum intr_level old_level = intr_disable ();
+#ifdef LOCK_PROFILE
+	lock_prof_released (lock);
+#endif
+	if (!thread_mlfqs) {
+		remove_with_lock (lock);
+		refresh_priority ();
+	}
 
 	lock->holder = NULL;
+	intr_set_level (old_level);
 	sema_up (&lock->semaphore);
 }
 
@@ -259,13 +313,540 @@ lock_held_by_current_thread (const struct lock *lock) {
 
 	return lock->holder == thread_current ();
 }
-
-/* One semaphore in a list. */
-struct semaphore_elem {
-	struct list_elem elem;              /* List element. */
-	struct semaphore semaphore;         /* This semaphore. */
+
+#ifdef LOCK_PROFILE
+/* Lock profiling.
+
+   Statistics are kept per call site, that is, per return address
+   of the lock_acquire() or lock_try_acquire() call, in a small
+   open-addressed hash table.  Times are in TSC cycles.  A wait is
+   measured from the start of lock_acquire() to the moment the lock
+   is ours; a hold is charged to the site that acquired the lock. */
+
+#define LOCK_PROF_SITES 256     /* Table size, a power of 2. */
+
+/* Statistics for one call site. */
+struct lock_prof_site {
+	void *site;                 /* Return address, or null if unused. */
+	long long acquires;         /* # of acquisitions. */
+	long long contended;        /* # of acquisitions that found it held. */
+	uint64_t wait_cycles;       /* Total time spent waiting. */
+	uint64_t max_wait_cycles;   /* Longest wait. */
+	uint64_t max_hold_cycles;   /* Longest hold. */
 };
 
+static struct lock_prof_site lock_prof_sites[LOCK_PROF_SITES];
+static long long lock_prof_dropped;     /* Acquisitions from untracked sites. */
+
+/* SITE의 통계 항목을 찾고, 없으면 새로 만듦 (table이 가득 찼으면 NULL) */
+static struct lock_prof_site *
+lock_prof_lookup (void *site) {
+	size_t i = ((uintptr_t) site >> 2) & (LOCK_PROF_SITES - 1);
+
+	for (size_t n = 0; n < LOCK_PROF_SITES; n++) {
+		struct lock_prof_site *ps = &lock_prof_sites[i];
+		if (ps->site == site)
+			return ps;
+		if (ps->site == NULL) {
+			ps->site = site;
+			return ps;
+		}
+		i = (i + 1) & (LOCK_PROF_SITES - 1);
+	}
+	return NULL;
+}
+
+/* LOCK을 SITE에서 획득한 직후에 호출됨 (START는 기다리기 시작한 시점) */
+static void
+lock_prof_acquired (struct lock *lock, void *site, bool contended,
+		uint64_t start) {
+	struct lock_prof_site *ps = lock_prof_lookup (site);
+	uint64_t now = rdtsc ();
+
+	ASSERT (intr_get_level () == INTR_OFF);
+
+	lock->prof_site = ps;
+	lock->prof_acquired = now;
+	if (ps == NULL) {
+		lock_prof_dropped++;
+		return;
+	}
+	ps->acquires++;
+	if (contended) {
+		uint64_t wait = now - start;
+		ps->contended++;
+		ps->wait_cycles += wait;
+		if (wait > ps->max_wait_cycles)
+			ps->max_wait_cycles = wait;
+	}
+}
+
+/* LOCK을 놓기 직전에 호출되어, 획득한 call site에 hold time을 기록 */
+static void
+lock_prof_released (struct lock *lock) {
+	struct lock_prof_site *ps = lock->prof_site;
+
+	ASSERT (intr_get_level () == INTR_OFF);
+
+	if (ps != NULL) {
+		uint64_t hold = rdtsc () - lock->prof_acquired;
+		if (hold > ps->max_hold_cycles)
+			ps->max_hold_cycles = hold;
+	}
+	lock->prof_site = NULL;
+}
+
+/* Prints lock statistics for every call site, most total wait
+   first.  The call sites are return addresses; pass them to the
+   `backtrace' utility to turn them into function names. */
+void
+lock_print_stats (void) {
+	static struct lock_prof_site *sorted[LOCK_PROF_SITES];
+	size_t cnt = 0;
+
+	for (size_t i = 0; i < LOCK_PROF_SITES; i++) {
+		struct lock_prof_site *ps = &lock_prof_sites[i];
+		size_t j;
+
+		if (ps->site == NULL)
+			continue;
+		for (j = cnt++; j > 0 && sorted[j - 1]->wait_cycles < ps->wait_cycles; j--)
+			sorted[j] = sorted[j - 1];
+		sorted[j] = ps;
+	}
+
+	printf ("Locks: %zu call sites", cnt);
+	if (lock_prof_dropped > 0)
+		printf (", %lld acquires from untracked sites", lock_prof_dropped);
+	printf ("\n");
+	for (size_t i = 0; i < cnt; i++) {
+		struct lock_prof_site *ps = sorted[i];
+		printf ("Lock site %p: %lld acquires, %lld contended, "
+				"%llu total/%llu max wait, %llu max hold cycles\n",
+				ps->site, ps->acquires, ps->contended,
+				(unsigned long long) ps->wait_cycles,
+				(unsigned long long) ps->max_wait_cycles,
+				(unsigned long long) ps->max_hold_cycles);
+	}
+}
+#endif /* LOCK_PROFILE */
+
+/* Initializes RW as an unheld reader-writer lock.
+
+   RW->lock serializes writers and also admits readers: a reader
+   holds it only long enough to register itself, while a writer
+   holds it for its whole critical section.  So once a writer is
+   waiting for the current readers to leave, newly arriving
+   readers queue up on RW->lock behind it, and the lock's normal
+   priority donation applies to them.
+
+   RW->writers counts the writers holding RW or waiting for it, so
+   the try functions can tell a writer from a reader that holds
+   RW->lock only for a moment. */
+void
+rwlock_init (struct rwlock *rw) {
+	ASSERT (rw != NULL);
+
+	lock_init (&rw->lock);
+	rw->readers = rw->writers = 0;
+	list_init (&rw->read_holds);
+	rw->drainer = NULL;
+	sema_init (&rw->drain, 0);
+}
+
+/* 호출자가 준 HOLD에 RW를 기록해 current thread와 RW 양쪽에 연결하고 reader 수를 늘림 */
+static void
+rwlock_add_reader (struct rwlock *rw, struct rwlock_hold *hold) {
+	struct thread *curr = thread_current ();
+	enum intr_level old_level = intr_disable ();
+
+	hold->rwlock = rw;
+	hold->holder = curr;
+	list_push_back (&rw->read_holds, &hold->elem);
+	list_push_back (&curr->read_holds, &hold->thread_elem);
+	rw->readers++;
+	intr_set_level (old_level);
+}
+
+/* current thread가 RW에 대해 가진 read hold를 반환 (없으면 NULL) */
+static struct rwlock_hold *
+rwlock_find_hold (const struct rwlock *rw) {
+	struct thread *curr = thread_current ();
+	struct list_elem *e;
+
+	for (e = list_begin (&curr->read_holds); e != list_end (&curr->read_holds);
+			e = list_next (e)) {
+		struct rwlock_hold *hold = list_entry (e, struct rwlock_hold, thread_elem);
+		if (hold->rwlock == rw)
+			return hold;
+	}
+	return NULL;
+}
+
+/* current thread의 read hold에서 RW를 지우고, 마지막 reader였다면 기다리는 writer를 깨움
+   - RW의 writer에게서 받던 donation도 돌려줌 */
+static void
+rwlock_remove_reader (struct rwlock *rw) {
+	enum intr_level old_level = intr_disable ();
+	struct rwlock_hold *hold = rwlock_find_hold (rw);
+
+	ASSERT (hold != NULL);
+
+	list_remove (&hold->elem);
+	list_remove (&hold->thread_elem);
+	rw->readers--;
+	if (!thread_mlfqs)
+		refresh_read_boost ();
+	if (rw->readers == 0 && rw->drainer != NULL)
+		sema_up (&rw->drain);
+	intr_set_level (old_level);
+}
+
+/* RW를 가지고 있거나 기다리는 writer 수를 늘림 */
+static void
+rwlock_add_writer (struct rwlock *rw) {
+	enum intr_level old_level = intr_disable ();
+
+	rw->writers++;
+	intr_set_level (old_level);
+}
+
+/* RW를 가지고 있거나 기다리는 writer 수를 줄임 */
+static void
+rwlock_remove_writer (struct rwlock *rw) {
+	enum intr_level old_level = intr_disable ();
+
+	ASSERT (rw->writers > 0);
+	rw->writers--;
+	intr_set_level (old_level);
+}
+
+/* RW->lock을 가진 current thread가 남은 reader들이 모두 빠져나갈 때까지 기다림
+   - 기다리는 동안 reader들에게 priority를 양도 */
+static void
+rwlock_drain_readers (struct rwlock *rw) {
+	struct thread *curr = thread_current ();
+	enum intr_level old_level = intr_disable ();
+
+	ASSERT (lock_held_by_current_thread (&rw->lock));
+
+	if (rw->readers > 0) {
+		rw->drainer = curr;
+		curr->drain_rwlock = rw;
+		if (!thread_mlfqs)
+			donate_priority_to_readers (rw);
+		sema_down (&rw->drain);
+		rw->drainer = NULL;
+		curr->drain_rwlock = NULL;
+	}
+	intr_set_level (old_level);
+}
+
+/* Acquires RW for reading, sleeping until no writer holds or is
+   waiting for it.  RW must not already be held by the current
+   thread.  HOLD records the read hold and must stay valid until
+   the current thread releases RW.
+
+   This function may sleep, so it must not be called within an
+   interrupt handler. */
+void
+rwlock_read_acquire (struct rwlock *rw, struct rwlock_hold *hold) {
+	ASSERT (rw != NULL);
+	ASSERT (hold != NULL);
+	ASSERT (!rwlock_read_held_by_current_thread (rw));
+
+	lock_acquire (&rw->lock);
+	rwlock_add_reader (rw, hold);
+	lock_release (&rw->lock);
+}
+
+/* Tries to acquire RW for reading and returns true if
+   successful, or false if a writer holds or is waiting for it.
+   On success, HOLD is used as by rwlock_read_acquire().  Never
+   sleeps. */
+bool
+rwlock_read_try_acquire (struct rwlock *rw, struct rwlock_hold *hold) {
+	enum intr_level old_level;
+	bool success = false;
+
+	ASSERT (rw != NULL);
+	ASSERT (hold != NULL);
+	ASSERT (!rwlock_read_held_by_current_thread (rw));
+
+	// writer가 없다면 RW->lock을 거치지 않고 바로 reader로 등록
+	// - RW->lock을 잠깐 가진 다른 reader 때문에 실패하지 않음
+	old_level = intr_disable ();
+	if (rw->writers == 0) {
+		rwlock_add_reader (rw, hold);
+		success = true;
+	}
+	intr_set_level (old_level);
+	return success;
+}
+
+/* Releases RW, which the current thread must hold for reading. */
+void
+rwlock_read_release (struct rwlock *rw) {
+	ASSERT (rw != NULL);
+	ASSERT (rwlock_read_held_by_current_thread (rw));
+
+	rwlock_remove_reader (rw);
+	test_max_priority ();
+}
+
+/* Acquires RW for writing, sleeping until it has no other
+   holders.  While it waits for readers to leave, the current
+   thread donates its priority to each of them.  RW must not
+   already be held by the current thread.
+
+   This function may sleep, so it must not be called within an
+   interrupt handler. */
+void
+rwlock_write_acquire (struct rwlock *rw) {
+	ASSERT (rw != NULL);
+	ASSERT (!rwlock_read_held_by_current_thread (rw));
+
+	rwlock_add_writer (rw);
+	lock_acquire (&rw->lock);
+	rwlock_drain_readers (rw);
+}
+
+/* Tries to acquire RW for writing and returns true if
+   successful, or false if any other thread holds it or another
+   writer is waiting for it.  May sleep briefly while an arriving
+   reader holds RW's internal lock, so it must not be called
+   within an interrupt handler. */
+bool
+rwlock_write_try_acquire (struct rwlock *rw) {
+	enum intr_level old_level;
+
+	ASSERT (rw != NULL);
+	ASSERT (!rwlock_read_held_by_current_thread (rw));
+
+	old_level = intr_disable ();
+	if (rw->readers > 0 || rw->writers > 0) {
+		intr_set_level (old_level);
+		return false;
+	}
+	rw->writers++;
+	intr_set_level (old_level);
+
+	// writer가 없으므로 RW->lock은 등록 중인 reader만 잠깐 가지고 있을 수 있음: 기다림
+	lock_acquire (&rw->lock);
+	if (rw->readers > 0) {
+		// 기다리는 사이에 reader가 들어옴
+		rwlock_remove_writer (rw);
+		lock_release (&rw->lock);
+		return false;
+	}
+	return true;
+}
+
+/* Releases RW, which the current thread must hold for writing. */
+void
+rwlock_write_release (struct rwlock *rw) {
+	ASSERT (rw != NULL);
+
+	rwlock_remove_writer (rw);
+	lock_release (&rw->lock);
+}
+
+/* Converts the current thread's read hold on RW into a write
+   hold, waiting for any other readers to leave.  Returns false,
+   still holding RW for reading, if another writer holds or is
+   waiting for RW: that writer is waiting for us, so we cannot
+   wait for it.  The caller may then release RW and acquire it
+   for writing from scratch.
+
+   This may also fail spuriously, while an arriving reader holds
+   RW's internal lock for the moment it takes to register.  Waiting
+   for that lock is not safe here: a writer arriving meanwhile could
+   be handed the lock first and then wait for our read hold. */
+bool
+rwlock_upgrade (struct rwlock *rw) {
+	enum intr_level old_level;
+
+	ASSERT (rw != NULL);
+	ASSERT (rwlock_read_held_by_current_thread (rw));
+
+	old_level = intr_disable ();
+	if (rw->writers > 0 || !lock_try_acquire (&rw->lock)) {
+		intr_set_level (old_level);
+		return false;
+	}
+	rw->writers++;
+	intr_set_level (old_level);
+
+	rwlock_remove_reader (rw);
+	rwlock_drain_readers (rw);
+	return true;
+}
+
+/* Converts the current thread's write hold on RW into a read
+   hold, letting waiting readers in.  HOLD is used as by
+   rwlock_read_acquire().  Never sleeps. */
+void
+rwlock_downgrade (struct rwlock *rw, struct rwlock_hold *hold) {
+	ASSERT (rw != NULL);
+	ASSERT (hold != NULL);
+	ASSERT (rwlock_write_held_by_current_thread (rw));
+
+	rwlock_add_reader (rw, hold);
+	rwlock_remove_writer (rw);
+	lock_release (&rw->lock);
+}
+
+/* Returns true if the current thread holds RW for reading,
+   false otherwise. */
+bool
+rwlock_read_held_by_current_thread (const struct rwlock *rw) {
+	ASSERT (rw != NULL);
+
+	return rwlock_find_hold (rw) != NULL;
+}
+
+/* Returns true if the current thread holds RW for writing,
+   false otherwise. */
+bool
+rwlock_write_held_by_current_thread (const struct rwlock *rw) {
+	ASSERT (rw != NULL);
+
+	return lock_held_by_current_thread (&rw->lock);
+}
+
+#ifdef LOCK_PROFILE
+/* All mutexes, for mutex_print_stats(). */
+static struct mutex *all_mutexes;
+#endif
+
+/* Initializes M, named NAME.  With LOCK_PROFILE, also registers
+   it for mutex_print_stats(). */
+void
+mutex_init (struct mutex *m, const char *name UNUSED) {
+	ASSERT (m != NULL);
+	ASSERT (name != NULL);
+
+	lock_init (&m->lock);
+#ifdef LOCK_PROFILE
+	strlcpy (m->name, name, sizeof m->name);
+	m->acquired_tsc = 0;
+	m->acquires = m->contended = m->spin_acquires = 0;
+	m->hold_cycles = m->max_hold_cycles = 0;
+
+	enum intr_level old_level = intr_disable ();
+	m->next = all_mutexes;
+	all_mutexes = m;
+	intr_set_level (old_level);
+#endif
+}
+
+/* M의 holder가 지금 CPU에서 실행 중인지 확인
+   - interrupt를 끈 동안에는 holder가 종료되어 사라질 수 없음 */
+static bool
+mutex_owner_running (struct mutex *m) {
+	enum intr_level old_level = intr_disable ();
+	struct thread *holder = m->lock.holder;
+	bool running = holder != NULL && holder->status == THREAD_RUNNING
+			&& holder != thread_current ();
+	intr_set_level (old_level);
+	return running;
+}
+
+/* holder가 실행 중인 동안 잠시 spin하며 M을 얻어보고, 얻었다면 true를 반환 */
+static bool
+mutex_spin (struct mutex *m) {
+	for (int i = 0; i < MUTEX_SPIN_MAX && mutex_owner_running (m); i++) {
+		cpu_relax ();
+		if (lock_try_acquire (&m->lock))
+			return true;
+	}
+	return false;
+}
+
+/* Acquires M, spinning briefly and then sleeping until it
+   becomes available if necessary.  M must not already be held
+   by the current thread.
+
+   This function may sleep, so it must not be called within an
+   interrupt handler. */
+void
+mutex_acquire (struct mutex *m) {
+	ASSERT (m != NULL);
+	ASSERT (!intr_context ());
+
+	if (!lock_try_acquire (&m->lock)) {
+		bool spun = mutex_spin (m);
+		if (!spun)
+			lock_acquire (&m->lock);
+#ifdef LOCK_PROFILE
+		// 통계는 M을 가진 상태에서 갱신
+		m->contended++;
+		if (spun)
+			m->spin_acquires++;
+#endif
+	}
+#ifdef LOCK_PROFILE
+	m->acquires++;
+	m->acquired_tsc = rdtsc ();
+#endif
+}
+
+/* Tries to acquire M and returns true if successful or false
+   on failure, without spinning or sleeping. */
+bool
+mutex_try_acquire (struct mutex *m) {
+	ASSERT (m != NULL);
+
+	if (!lock_try_acquire (&m->lock))
+		return false;
+#ifdef LOCK_PROFILE
+	m->acquires++;
+	m->acquired_tsc = rdtsc ();
+#endif
+	return true;
+}
+
+/* Releases M, which must be owned by the current thread. */
+void
+mutex_release (struct mutex *m) {
+	ASSERT (m != NULL);
+	ASSERT (mutex_held_by_current_thread (m));
+
+#ifdef LOCK_PROFILE
+	uint64_t held = rdtsc () - m->acquired_tsc;
+	m->hold_cycles += held;
+	if (held > m->max_hold_cycles)
+		m->max_hold_cycles = held;
+#endif
+	lock_release (&m->lock);
+}
+
+/* Returns true if the current thread holds M, false otherwise. */
+bool
+mutex_held_by_current_thread (const struct mutex *m) {
+	ASSERT (m != NULL);
+
+	return lock_held_by_current_thread (&m->lock);
+}
+
+#ifdef LOCK_PROFILE
+/* Prints statistics for every mutex that has been acquired. */
+void
+mutex_print_stats (void) {
+	struct mutex *m;
+
+	for (m = all_mutexes; m != NULL; m = m->next) {
+		if (m->acquires == 0)
+			continue;
+		printf ("Mutex %s: %lld acquires, %lld contended (%lld spun), "
+				"%llu avg/%llu max cycles held\n",
+				m->name, m->acquires, m->contended, m->spin_acquires,
+				(unsigned long long) (m->hold_cycles / m->acquires),
+				(unsigned long long) m->max_hold_cycles);
+	}
+}
+#endif /* LOCK_PROFILE */
+
 /* Initializes condition variable COND.  A condition variable
    allows one piece of code to signal a condition and cooperating
    code to receive the signal and act upon it. */
@@ -273,7 +854,15 @@ void
 cond_init (struct condition *cond) {
 	ASSERT (cond != NULL);
 
-	list_init (&cond->waiters);
+	rb_init (&cond->waiters, cond_waiter_less, NULL);
+}
+
+/* cond의 waiters 정렬 기준: priority가 높은 thread가 앞 (같으면 먼저 기다린 thread가 앞) */
+static bool
+cond_waiter_less (const struct rb_elem *a, const struct rb_elem *b,
+		void *aux UNUSED) {
+	return rb_entry (a, struct thread, cond_elem)->priority
+			> rb_entry (b, struct thread, cond_elem)->priority;
 }
 
 /* Atomically releases LOCK and waits for COND to be signaled by
@@ -298,23 +887,47 @@ cond_init (struct condition *cond) {
    we need to sleep. */
 void
 cond_wait (struct condition *cond, struct lock *lock) {
-	struct semaphore_elem waiter;
+	struct thread *curr = thread_current ();
+	enum intr_level old_level;
 
 	ASSERT (cond != NULL);
 	ASSERT (lock != NULL);
 	ASSERT (!intr_context ());
 	ASSERT (lock_held_by_current_thread (lock));
 
-	sema_init (&waiter.semaphore, 0); /* 새롭게 선언된 semaphore value 0으로 초기화 및 list member 초기화*/
-	list_insert_ordered(&cond->waiters, &waiter.elem, sema_compare_priority, 0);
-	/* cond_wait에 진입한 서로 다른 thread는 각각 새로운 semaphore에 속하게 되며 해당 semaphore를 관리하는 list가 cond->waiters */
-	/*기존 push back 방식에서 cond waiters 의 element에 대응하는 쓰레드간의 priority 순서로 insert하는 방식으로 변경*/
+	/* current thread를 priority 순서로 waiters에 바로 넣음 (O(log n))
+	   - 기다리는 동안 priority가 바뀌면 thread.c에서 위치를 다시 잡아줌 */
+	old_level = intr_disable ();
+	curr->wait_on_cond = cond;
+	rb_insert (&cond->waiters, &curr->cond_elem);
+	intr_set_level (old_level);
 
 	lock_release (lock);
-	sema_down (&waiter.semaphore); 
+
+	/* lock_release에서 양보한 사이에 이미 signal을 받았다면 wait_on_cond가 비어 있음 */
+	old_level = intr_disable ();
+	if (curr->wait_on_cond != NULL)
+		thread_block ();
+	intr_set_level (old_level);
+
 	lock_acquire (lock);
 }
 
+/* COND의 가장 앞 waiter를 꺼내 깨움 (preemption 검사는 호출한 쪽에서 함) */
+static void
+cond_wake_one (struct condition *cond) {
+	struct thread *t = rb_entry (rb_min (&cond->waiters), struct thread, cond_elem);
+
+	ASSERT (intr_get_level () == INTR_OFF);
+
+	rb_remove (&cond->waiters, &t->cond_elem);
+	t->wait_on_cond = NULL;
+	/* waiter는 thread_block 전까지 다른 곳에서 block되지 않으므로
+	   BLOCKED라면 cond_wait 안에서 잠든 상태 */
+	if (t->status == THREAD_BLOCKED)
+		thread_unblock (t);
+}
+
 /* If any threads are waiting on COND (protected by LOCK), then
    this function signals one of them to wake up from its wait.
    LOCK must be held before calling this function.
@@ -324,18 +937,18 @@ cond_wait (struct condition *cond, struct lock *lock) {
    interrupt handler. */
 void
 cond_signal (struct condition *cond, struct lock *lock UNUSED) {
+	enum intr_level old_level;
+
 	ASSERT (cond != NULL);
 	ASSERT (lock != NULL);
 	ASSERT (!intr_context ());
 	ASSERT (lock_held_by_current_thread (lock));
 
-	if (!list_empty (&cond->waiters)){
-		/* waiting중 priority 변경 가능성이 있기 때문에, semaphore waiting list를 내림차순으로 sorting 한다. */
-		list_sort(&cond->waiters, sema_compare_priority,0);
-		sema_up (&list_entry (list_pop_front (&cond->waiters),
-					struct semaphore_elem, elem)->semaphore);
-	}
-
+	old_level = intr_disable ();
+	if (!rb_empty (&cond->waiters))
+		cond_wake_one (cond);
+	intr_set_level (old_level);
+	test_max_priority ();
 }
 
 /* Wakes up all threads, if any, waiting on COND (protected by
@@ -345,24 +958,72 @@ cond_signal (struct condition *cond, struct lock *lock UNUSED) {
    make sense to try to signal a condition variable within an
    interrupt handler. */
 void
-cond_broadcast (struct condition *cond, struct lock *lock) {
+cond_broadcast (struct condition *cond, struct lock *lock UNUSED) {
+	enum intr_level old_level;
+
 	ASSERT (cond != NULL);
 	ASSERT (lock != NULL);
+	ASSERT (!intr_context ());
+	ASSERT (lock_held_by_current_thread (lock));
+
+	/* 모두 깨운 뒤 한 번만 preemption을 검사 */
+	old_level = intr_disable ();
+	while (!rb_empty (&cond->waiters))
+		cond_wake_one (cond);
+	intr_set_level (old_level);
+	test_max_priority ();
+}
+
+/* Initializes spinlock LOCK to the unlocked state. */
+void
+spin_lock_init (struct spinlock *lock) {
+	ASSERT (lock != NULL);
+
+	lock->locked = 0;
+	lock->holder = NULL;
+}
+
+/* Disables interrupts and acquires LOCK, spinning until it is
+   free.  Returns the previous interrupt level, which must be
+   passed to spin_unlock_irqrestore().
+
+   The holder must not sleep.  On a uniprocessor disabling
+   interrupts already excludes every other thread, so the lock
+   word is never contended there; it is taken anyway so that the
+   same critical sections stay correct once more than one CPU
+   runs kernel code. */
+enum intr_level
+spin_lock_irqsave (struct spinlock *lock) {
+	enum intr_level old_level;
+
+	ASSERT (lock != NULL);
+	ASSERT (!spin_lock_held_by_current_thread (lock));
 
-	while (!list_empty (&cond->waiters))
-		cond_signal (cond, lock);
+	old_level = intr_disable ();
+	while (__atomic_exchange_n (&lock->locked, 1, __ATOMIC_ACQUIRE))
+		while (lock->locked)
+			asm volatile ("pause");
+	lock->holder = thread_current ();
+	return old_level;
 }
 
-/* semaphore element 구조체의 list elem 멤버를 인자로 받아 나머지 멤버인 semaphore에 속하는
-	thread의 prioity 사이의 우선순위 비교.*/
-bool sema_compare_priority(const struct list_elem *a, const struct list_elem *b, void *aux UNUSED)
-{
-	struct semaphore_elem *a_sema = list_entry (a, struct semaphore_elem, elem); /*member로 structure 구하기*/
-	struct semaphore_elem *b_sema = list_entry (b, struct semaphore_elem, elem); 
+/* Releases LOCK, which must be held by the current thread, and
+   restores the interrupt level OLD_LEVEL. */
+void
+spin_unlock_irqrestore (struct spinlock *lock, enum intr_level old_level) {
+	ASSERT (lock != NULL);
+	ASSERT (spin_lock_held_by_current_thread (lock));
 
-	struct list *waiter_a_sema = &(a_sema->semaphore.waiters);  /*stucture -> the other member's member(list) 값 구하기*/
-	struct list *waiter_b_sema = &(b_sema->semaphore.waiters);
+	lock->holder = NULL;
+	__atomic_store_n (&lock->locked, 0, __ATOMIC_RELEASE);
+	intr_set_level (old_level);
+}
 
-	return list_entry(list_begin(waiter_a_sema), struct thread, elem)->priority	 /* 구한 list 의 begain thread의 priority 사이 대소비교 */
-		> list_entry(list_begin(waiter_b_sema),struct thread, elem)->priority;
-}
\ No newline at end of file
+/* Returns true if the current thread holds LOCK, false
+   otherwise. */
+bool
+spin_lock_held_by_current_thread (const struct spinlock *lock) {
+	ASSERT (lock != NULL);
+
+	return lock->locked && lock->holder == thread_current ();
+}
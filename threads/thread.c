@@ -1,5 +1,6 @@
 #include "threads/thread.h"
 #include <debug.h>
+#include <inttypes.h>
 #include <stddef.h>
 #include <random.h>
 #include <stdio.h>
@@ -9,7 +10,9 @@
 #include "threads/intr-stubs.h"
 #include "threads/palloc.h"
 #include "threads/synch.h"
+#include "threads/switch.h"
 #include "threads/vaddr.h"
+#include "devices/timer.h"
 #include "intrinsic.h"
 #ifdef USERPROG
 #include "userprog/process.h"
@@ -24,13 +27,28 @@
    Do not modify this value. */
 #define THREAD_BASIC 0xd42df210
 
-/* List of processes in THREAD_READY state, that is, processes
-   that are ready to run but not actually running. */
-static struct list ready_list;
-
-/* List of process in THREAD_BLOCK state */
-static struct list sleep_list;
-// sleep_list에서 awake되는 시점이 가장 빠른 thread의 awake_ticks 시점
+/* Run queues of processes in THREAD_READY state, that is, processes
+   that are ready to run but not actually running.
+   - priority 별로 FIFO queue를 하나씩 두고 (PRI_MIN..PRI_MAX)
+   - ready_mask의 i번째 bit로 ready_queues[i]가 비어있지 않은지를 표시
+   - 가장 높은 priority의 queue는 mask의 최상위 bit로 바로 찾을 수 있음 (O(1)) */
+#define READY_QUEUE_CNT (PRI_MAX - PRI_MIN + 1)
+static struct list ready_queues[READY_QUEUE_CNT];
+static uint64_t ready_mask;
+
+/* timer_sleep()으로 잠든 thread들의 min-heap (wakeup_tick 기준)
+   - 배열로 구현한 binary heap이며, 가득 차면 두 배로 늘림
+   - 삽입/삭제는 O(log n), 가장 빠른 wakeup_tick은 sleep_heap[0]에서 바로 확인 */
+struct sleep_entry {
+	int64_t wakeup_tick;                /* 깨어나야 할 시점 (heap의 key). */
+	uint64_t seq;                       /* 같은 tick끼리 잠든 순서를 유지하기 위함. */
+	struct thread *t;                   /* 잠든 thread. */
+};
+static struct sleep_entry *sleep_heap;
+static size_t sleep_heap_cnt;           /* heap에 들어 있는 thread의 수. */
+static size_t sleep_heap_cap;           /* heap 배열이 담을 수 있는 최대 수. */
+static size_t sleep_heap_pages;         /* heap 배열이 차지하는 page 수. */
+// sleep heap에서 awake되는 시점이 가장 빠른 thread의 awake_ticks 시점
 static int64_t next_tick_to_awake; 
 
 /* Idle thread. */
@@ -40,28 +58,134 @@ static struct thread *idle_thread;
 static struct thread *initial_thread;
 
 /* Lock used by allocate_tid(). */
-static struct lock tid_lock;
+static struct spinlock tid_lock;
+
+/* MLFQS: list of all threads that have not exited yet, used to
+   decay every thread's recent_cpu once per second. */
+static struct list all_list;
+static fixed_t load_avg;        /* System load average (17.14). */
+static int ready_cnt;           /* # of threads in the run queues. */
 
 /* Thread destruction requests */
 static struct list destruction_req;
 
+/* 종료된 thread의 page와 FDT를 해제하지 않고 모아두었다가 재사용하는 cache
+   - thread page는 init_thread에서 struct thread 부분만 초기화하면 되므로 page 전체를 0으로 채우지 않아도 됨
+   - FDT는 process_exit에서 모든 fd를 닫아 비운 뒤 넣으므로 0으로 채워진 상태
+   - interrupt를 끈 상태에서만 접근 */
+#define THREAD_CACHE_MAX 16     /* Max cached thread pages. */
+#define FDT_CACHE_MAX 4         /* Max cached FDTs. */
+static void *thread_cache[THREAD_CACHE_MAX];
+static size_t thread_cache_cnt;
+static struct file **fdt_cache[FDT_CACHE_MAX];
+static size_t fdt_cache_cnt;
+
 /* Statistics. */
 static long long idle_ticks;    /* # of timer ticks spent idle. */
 static long long kernel_ticks;  /* # of timer ticks in kernel threads. */
 static long long user_ticks;    /* # of timer ticks in user programs. */
+static int64_t idle_ns;         /* # of nanoseconds spent idle. */
+static int64_t kernel_ns;       /* # of nanoseconds in kernel threads. */
+static int64_t user_ns;         /* # of nanoseconds in user programs. */
+static int64_t switch_ns;       /* timer_now_ns() at the last thread switch. */
 
 /* Scheduling. */
 #define TIME_SLICE 4            /* # of timer ticks to give each thread. */
+#define THREAD_AWAKE_BATCH 16   /* Max threads woken per thread_awake(). */
 static unsigned thread_ticks;   /* # of timer ticks since last yield. */
 
-/* Donation. */
-#define DONATE_MAX_DEPTH 8		/* maximum number of depth to donate */
-
 /* If false (default), use round-robin scheduler.
    If true, use multi-level feedback queue scheduler.
    Controlled by kernel command-line option "-o mlfqs". */
 bool thread_mlfqs;
 
+/* If true, switch between kernel threads through a full
+   intr_frame and iretq, as before the callee-saved-register
+   switch was added.  Kept for comparison.  Controlled by kernel
+   command-line option "-iret-switch". */
+bool thread_iret_switch;
+
+/* If true, use the proportional-share scheduler instead of
+   strict priorities.  Controlled by kernel command-line option
+   "-fair". */
+bool thread_fair;
+
+/* Proportional-share scheduler (-fair).
+   - ready thread들은 vruntime(weight로 나눈 누적 실행 시간) 기준의 red-black tree에 보관
+   - 항상 vruntime이 가장 작은 thread를 실행하므로, 각 thread는 weight에 비례한 CPU를 받음
+   - vruntime의 단위는 PRI_DEFAULT thread 기준 1/FAIR_WEIGHT_DEFAULT tick */
+#define FAIR_WEIGHT_DEFAULT 1024        /* Weight of a PRI_DEFAULT thread. */
+#define FAIR_LATENCY 8                  /* Ticks in which each ready thread runs once. */
+#define FAIR_MIN_GRANULARITY 1          /* Shortest time slice, in ticks. */
+#define FAIR_WAKEUP_GRANULARITY FAIR_WEIGHT_DEFAULT  /* vruntime lead to preempt. */
+#define FAIR_SLEEPER_CREDIT (FAIR_LATENCY * FAIR_WEIGHT_DEFAULT / 2)
+static struct rb_tree fair_tree;        /* Ready threads, ordered by vruntime. */
+static int64_t fair_min_vruntime;       /* Monotonic lower bound of vruntime. */
+static int64_t fair_load;               /* Sum of weights of ready threads. */
+
+/* If true, use the stride scheduler.  Controlled by kernel
+   command-line option "-stride". */
+bool thread_stride;
+
+/* Stride scheduler (-stride).
+   - 각 thread는 tickets에 반비례하는 stride(STRIDE1 / tickets)를 가지고,
+     한 tick 실행할 때마다 pass가 stride만큼 증가함
+   - ready thread들은 pass 기준의 red-black tree에 보관하고 pass가 가장 작은 thread를 실행
+   - lock을 기다리는 thread는 priority 대신 자신의 tickets를 holder에게 빌려줌 (ticket transfer) */
+#define STRIDE1 (1 << 20)               /* Pass advanced per tick at 1 ticket. */
+#define STRIDE_QUANTUM 1                /* Time slice, in ticks. */
+static struct rb_tree stride_tree;      /* Ready threads, ordered by pass. */
+static int64_t stride_min_pass;         /* Monotonic lower bound of pass. */
+
+/* Earliest-deadline-first real-time class.
+   - thread_create_periodic()으로 만든 thread는 매 period마다 runtime 만큼의 budget을 받음
+   - ready 상태인 EDF thread는 다른 모든 thread보다 먼저, deadline이 빠른 순서로 실행됨
+   - budget을 다 쓴 thread는 다음 period까지 일반 thread로 취급됨 (throttled)
+   - 대역폭(runtime / period)의 합이 EDF_BW_LIMIT를 넘는 thread는 생성을 거부함 */
+#define EDF_BW_SHIFT 20                         /* Fixed-point bandwidth. */
+#define EDF_BW_LIMIT ((95 << EDF_BW_SHIFT) / 100)  /* Leave 5% to others. */
+static struct rb_tree edf_tree;         /* Ready EDF threads, by deadline. */
+static int64_t edf_bw;                  /* Bandwidth of admitted threads. */
+static long long edf_jobs;              /* # of completed EDF jobs. */
+static long long edf_misses;            /* # of jobs that missed their deadline. */
+
+/* If true, record scheduler events and dump them at shutdown.
+   Controlled by kernel command-line option "-sched-trace". */
+bool thread_trace;
+
+/* Scheduler event trace (-sched-trace).
+   - TRACE_PAGES 크기의 ring buffer에 가장 최근 TRACE_CNT개의 event를 보관
+   - tracing이 꺼져 있으면 trace_buf가 NULL이므로 각 지점에서 비교 한 번만 함
+   - thread 이름은 tid % TRACE_NAME_CNT 자리에 따로 보관 (event를 작게 유지) */
+enum trace_type {
+	TRACE_SWITCH,               /* TID가 ARG 대신 실행되기 시작함. */
+	TRACE_BLOCK,                /* TID가 block됨. */
+	TRACE_UNBLOCK,              /* ARG(interrupt면 0)가 TID를 ready로 만듦. */
+	TRACE_DONATE,               /* TID의 priority가 ARG에서 바뀜. */
+	TRACE_SLEEP,                /* TID가 ARG tick까지 잠듦. */
+	TRACE_WAKE,                 /* ARG tick에 TID를 깨움. */
+	TRACE_CREATE,               /* ARG가 TID를 생성함. */
+	TRACE_EXIT,                 /* TID가 종료됨. */
+};
+
+struct trace_event {
+	int64_t time;               /* timer_now_ns(). */
+	tid_t tid;                  /* Thread the event is about. */
+	int32_t arg;                /* See enum trace_type. */
+	uint8_t type;               /* enum trace_type. */
+	uint8_t priority;           /* TID's priority after the event. */
+};
+
+#define TRACE_PAGES 16
+#define TRACE_CNT (TRACE_PAGES * PGSIZE / sizeof (struct trace_event))
+#define TRACE_NAME_CNT 256
+static struct trace_event *trace_buf;   /* NULL unless tracing. */
+static uint64_t trace_head;             /* # of events ever recorded. */
+static struct {
+	tid_t tid;
+	char name[16];
+} trace_names[TRACE_NAME_CNT];
+
 static void kernel_thread (thread_func *, void *aux);
 
 static void idle (void *aux UNUSED);
@@ -69,8 +193,52 @@ static struct thread *next_thread_to_run (void);
 static void init_thread (struct thread *, const char *name, int priority);
 static void do_schedule(int status);
 static void schedule (void);
+static void account_run_ns (struct thread *);
+static void trace_record (enum trace_type, struct thread *, int32_t arg);
+
+/* Records a TYPE event about T, if tracing is on. */
+static inline void
+trace (enum trace_type type, struct thread *t, int32_t arg) {
+	if (trace_buf != NULL)
+		trace_record (type, t, arg);
+}
+static void thread_launch_iret (struct thread *);
 static tid_t allocate_tid (void);
 
+static void ready_queue_push (struct thread *);
+static void ready_queue_remove (struct thread *);
+static struct thread *ready_queue_pop (void);
+static int ready_queue_max_priority (void);
+static bool ready_queue_preempts (struct thread *);
+
+static int fair_weight (int priority);
+static bool fair_less (const struct rb_elem *, const struct rb_elem *, void *);
+static void fair_tick (struct thread *);
+static unsigned fair_slice (struct thread *);
+
+static int64_t stride_tickets (const struct thread *);
+static bool stride_less (const struct rb_elem *, const struct rb_elem *, void *);
+static void stride_tick (struct thread *);
+static void stride_lend (struct lock *, int64_t tickets);
+
+static tid_t do_thread_create (const char *name, int priority,
+		thread_func *, void *aux,
+		int64_t runtime, int64_t period, int64_t deadline);
+static bool edf_queued (const struct thread *);
+static int64_t edf_bandwidth (int64_t runtime, int64_t period);
+static bool edf_less (const struct rb_elem *, const struct rb_elem *, void *);
+
+static void mlfqs_tick (struct thread *);
+static void mlfqs_update_priority (struct thread *);
+static void mlfqs_update_recent_cpu (struct thread *);
+static void mlfqs_update_load_avg (void);
+
+struct sleep_entry;
+static bool sleep_entry_less (const struct sleep_entry *, const struct sleep_entry *);
+static void sleep_heap_push (struct thread *);
+static struct thread *sleep_heap_pop (void);
+static void sleep_heap_grow (size_t old_cap);
+
 /* Returns true if T appears to point to a valid thread. */
 #define is_thread(t) ((t) != NULL && (t)->magic == THREAD_MAGIC)
 
@@ -114,10 +282,23 @@ thread_init (void) {
 	lgdt (&gdt_ds);
 
 	/* Init the globla thread context */
-	lock_init (&tid_lock);
-	list_init (&ready_list);
+	spin_lock_init (&tid_lock);
+	for (int i = 0; i < READY_QUEUE_CNT; i++)
+		list_init (&ready_queues[i]);
+	ready_mask = 0;
+	ready_cnt = 0;
+	rb_init (&fair_tree, fair_less, NULL);
+	rb_init (&stride_tree, stride_less, NULL);
+	stride_min_pass = 0;
+	rb_init (&edf_tree, edf_less, NULL);
+	edf_bw = 0;
+	fair_min_vruntime = fair_load = 0;
+	list_init (&all_list);
+	load_avg = 0;
 	list_init (&destruction_req);
-	list_init (&sleep_list);
+	sleep_heap = NULL;
+	sleep_heap_cnt = sleep_heap_cap = sleep_heap_pages = 0;
+	next_tick_to_awake = INT64_MAX;
 
 	/* Set up a thread structure for the running thread. */
 	initial_thread = running_thread ();
@@ -133,6 +314,10 @@ thread_start (void) {
 	/* Create the idle thread. */
 	struct semaphore idle_started;
 	sema_init (&idle_started, 0);
+	if (thread_trace) {
+		trace_buf = palloc_get_multiple (PAL_ASSERT | PAL_ZERO, TRACE_PAGES);
+		trace (TRACE_CREATE, initial_thread, 0);
+	}
 	thread_create ("idle", PRI_MIN, idle, &idle_started);
 
 	/* Start preemptive thread scheduling. */
@@ -147,6 +332,7 @@ thread_start (void) {
 void
 thread_tick (void) {
 	struct thread *t = thread_current ();
+	unsigned slice;
 
 	/* Update statistics. */
 	if (t == idle_thread)
@@ -158,16 +344,122 @@ thread_tick (void) {
 	else
 		kernel_ticks++;
 
+	if (thread_mlfqs)
+		mlfqs_tick (t);
+	else if (thread_fair && t != idle_thread)
+		fair_tick (t);
+	else if (thread_stride && t != idle_thread)
+		stride_tick (t);
+
+	// EDF thread가 이번 period의 budget을 모두 사용하면 다음 period까지 일반 thread로 내려감
+	if (edf_queued (t) && --t->edf_budget <= 0) {
+		t->edf_throttled = true;
+		intr_yield_on_return ();
+	}
+
 	/* Enforce preemption. */
-	if (++thread_ticks >= TIME_SLICE)
+	if (thread_fair)
+		slice = fair_slice (t);
+	else if (thread_stride)
+		slice = STRIDE_QUANTUM;
+	else
+		slice = TIME_SLICE;
+	if (++thread_ticks >= slice)
 		intr_yield_on_return ();
 }
 
+/* Accounts CNT timer ticks that were skipped while the CPU was
+   idle in tickless mode.  Called by the timer with interrupts
+   off. */
+void
+thread_add_idle_ticks (int64_t cnt) {
+	ASSERT (intr_get_level () == INTR_OFF);
+	idle_ticks += cnt;
+}
+
+/* T가 마지막 thread 전환 이후 CPU를 사용한 시간을 ns 단위로 누적
+   - tick 단위 통계와 같은 기준으로 idle / kernel / user를 구분함 */
+static void
+account_run_ns (struct thread *t) {
+	int64_t now = timer_now_ns ();
+	int64_t delta = now - switch_ns;
+
+	switch_ns = now;
+	if (t == idle_thread)
+		idle_ns += delta;
+#ifdef USERPROG
+	else if (t->pml4 != NULL)
+		user_ns += delta;
+#endif
+	else
+		kernel_ns += delta;
+}
+
+/* Appends a TYPE event about T to the trace ring buffer,
+   overwriting the oldest event once it is full. */
+static void
+trace_record (enum trace_type type, struct thread *t, int32_t arg) {
+	enum intr_level old_level = intr_disable ();
+	struct trace_event *e = &trace_buf[trace_head++ % TRACE_CNT];
+
+	e->time = timer_now_ns ();
+	e->tid = t->tid;
+	e->arg = arg;
+	e->type = type;
+	e->priority = t->priority;
+	if (type == TRACE_CREATE) {
+		trace_names[t->tid % TRACE_NAME_CNT].tid = t->tid;
+		strlcpy (trace_names[t->tid % TRACE_NAME_CNT].name, t->name,
+				sizeof trace_names[0].name);
+	}
+	intr_set_level (old_level);
+}
+
+/* Dumps the scheduler trace to the console, oldest event first,
+   in the format read by the `sched-trace' utility.  Does nothing
+   unless tracing is on. */
+void
+thread_trace_dump (void) {
+	static const char *type_names[] = {
+		"switch", "block", "unblock", "donate",
+		"sleep", "wake", "create", "exit",
+	};
+	struct trace_event *buf = trace_buf;
+	uint64_t first, i;
+
+	if (buf == NULL)
+		return;
+
+	// 출력하는 동안 생기는 event가 buffer를 덮어쓰지 않도록 tracing을 끔
+	trace_buf = NULL;
+	first = trace_head > TRACE_CNT ? trace_head - TRACE_CNT : 0;
+	printf ("sched-trace: begin %"PRIu64" events, %"PRIu64" dropped\n",
+			trace_head - first, first);
+	for (i = 0; i < TRACE_NAME_CNT; i++)
+		if (trace_names[i].name[0] != '\0')
+			printf ("sched-trace: name %d %s\n",
+					trace_names[i].tid, trace_names[i].name);
+	for (i = first; i < trace_head; i++) {
+		struct trace_event *e = &buf[i % TRACE_CNT];
+		printf ("sched-trace: %"PRId64" %s %d %d %d\n", e->time,
+				type_names[e->type], e->tid, e->priority, e->arg);
+	}
+	printf ("sched-trace: end\n");
+}
+
 /* Prints thread statistics. */
 void
 thread_print_stats (void) {
+	enum intr_level old_level = intr_disable ();
+	account_run_ns (thread_current ());
+	intr_set_level (old_level);
+
 	printf ("Thread: %lld idle ticks, %lld kernel ticks, %lld user ticks\n",
 			idle_ticks, kernel_ticks, user_ticks);
+	printf ("Thread: %"PRId64" ns idle, %"PRId64" ns kernel, %"PRId64" ns user\n",
+			idle_ns, kernel_ns, user_ns);
+	if (edf_jobs > 0)
+		printf ("EDF: %lld jobs, %lld deadline misses\n", edf_jobs, edf_misses);
 }
 
 /* Creates a new kernel thread named NAME with the given initial
@@ -188,6 +480,92 @@ thread_print_stats (void) {
 tid_t
 thread_create (const char *name, int priority,
 		thread_func *function, void *aux) {
+	return do_thread_create (name, priority, function, aux, 0, 0, 0);
+}
+
+/* Creates a new kernel thread in the earliest-deadline-first
+   real-time class, like thread_create().  Every PERIOD ticks the
+   thread is given RUNTIME ticks of CPU time, which it must use
+   within DEADLINE ticks of the start of the period.  While it has
+   budget left it runs ahead of every non-real-time thread, and
+   real-time threads run in order of their deadlines.  FUNCTION
+   should call thread_wait_period() when it finishes each
+   period's work.
+
+   Returns TID_ERROR if the parameters are not 0 < RUNTIME <=
+   DEADLINE <= PERIOD, if admitting the thread would let the
+   real-time threads use more than 95% of the CPU, or if creation
+   fails. */
+tid_t
+thread_create_periodic (const char *name, int64_t runtime, int64_t period,
+		int64_t deadline, thread_func *function, void *aux) {
+	enum intr_level old_level;
+	int64_t bw;
+	tid_t tid;
+
+	if (runtime <= 0 || runtime > deadline || deadline > period)
+		return TID_ERROR;
+
+	/* Admission control. */
+	bw = edf_bandwidth (runtime, period);
+	old_level = intr_disable ();
+	if (edf_bw + bw > EDF_BW_LIMIT) {
+		intr_set_level (old_level);
+		return TID_ERROR;
+	}
+	edf_bw += bw;
+	intr_set_level (old_level);
+
+	tid = do_thread_create (name, PRI_DEFAULT, function, aux,
+			runtime, period, deadline);
+	if (tid == TID_ERROR) {
+		old_level = intr_disable ();
+		edf_bw -= bw;
+		intr_set_level (old_level);
+	}
+	return tid;
+}
+
+/* Ends the current period's job of the running real-time thread
+   and sleeps until its next period starts.  A job that ends
+   after its deadline is counted as a deadline miss.  If the job
+   overran its whole period, the next one starts right away. */
+void
+thread_wait_period (void) {
+	struct thread *curr = thread_current ();
+	enum intr_level old_level;
+	int64_t now, next;
+
+	ASSERT (curr->edf_period != 0);
+
+	old_level = intr_disable ();
+	now = timer_ticks ();
+	edf_jobs++;
+	if (now > curr->edf_abs_deadline) {
+		edf_misses++;
+		curr->edf_misses++;
+	}
+
+	// 다음 job의 시작 시점과 deadline, budget을 설정
+	next = curr->edf_release + curr->edf_period;
+	if (next < now)
+		next = now;
+	curr->edf_release = next;
+	curr->edf_abs_deadline = next + curr->edf_deadline;
+	curr->edf_budget = curr->edf_runtime;
+	curr->edf_throttled = false;
+	intr_set_level (old_level);
+
+	if (next > now)
+		thread_sleep (next);
+}
+
+/* Creates a thread for thread_create() or, if PERIOD is nonzero,
+   for thread_create_periodic(). */
+static tid_t
+do_thread_create (const char *name, int priority,
+		thread_func *function, void *aux,
+		int64_t runtime, int64_t period, int64_t deadline) {
 	// function: thread가 생성된 뒤 그 thread의 context에서 수행할 업무(thread routine)
 	// aux: function에 넘길 인자
 	struct thread *t;
@@ -195,14 +573,34 @@ thread_create (const char *name, int priority,
 
 	ASSERT (function != NULL);
 
-	/* Allocate thread. */
-	t = palloc_get_page (PAL_ZERO);
+	/* Allocate thread, preferably from the cache of exited ones. */
+	enum intr_level old_level = intr_disable ();
+	t = thread_cache_cnt > 0 ? thread_cache[--thread_cache_cnt] : NULL;
+	intr_set_level (old_level);
+	if (t == NULL)
+		t = palloc_get_page (0);
 	if (t == NULL)
 		return TID_ERROR;
 
 	/* Initialize thread. */
 	init_thread (t, name, priority);
 	tid = t->tid = allocate_tid ();
+	trace (TRACE_CREATE, t, thread_current ()->tid);
+
+	// MLFQS에서는 nice와 recent_cpu를 부모로부터 물려받고, priority 인자는 무시함
+	if (thread_mlfqs) {
+		t->nice = thread_current ()->nice;
+		t->recent_cpu = thread_current ()->recent_cpu;
+		mlfqs_update_priority (t);
+	}
+	// fair scheduler에서는 현재 가장 작은 vruntime에서 시작 (기존 thread보다 앞서지 않도록)
+	if (thread_fair)
+		t->vruntime = fair_min_vruntime;
+	// stride scheduler에서는 부모의 tickets를 물려받고, 현재 가장 작은 pass에서 시작
+	if (thread_stride) {
+		t->tickets = thread_current ()->tickets;
+		t->pass = stride_min_pass;
+	}
 
 	/* parent-child 관계 
 		- 현재 thread의 chilren list에 새로 생성된 thread 추가 (FIFO 방식)
@@ -211,13 +609,10 @@ thread_create (const char *name, int priority,
 	list_push_back(&parent->children, &t->child_elem);
 
 	/* file descriptor 관련
-		- palloc을 활용해 kernel memory fool에 FDT 생성
+		- FDT는 처음 필요할 때 thread_alloc_fdt로 생성 (파일을 열지 않는 kernel thread는 만들지 않음)
 		- next_fd를 2로 초기화: 0은 STDIN, 1은 STDOUT
 	 */
-	// printf("[thread_create]  %d, %d, %p \n", PAL_ZERO, FDT_PAGE_CNT, t->fdt);
-	t->fdt = (struct file**) palloc_get_multiple(PAL_ZERO, FDT_PAGE_CNT);
-	t->fdt[0] = 10; // dummy value 
-	t->fdt[1] = 11; // dummy value
+	t->fdt = NULL;
 	t->next_fd = 2; // 다음에 들어갈 파일의 fd값
 	t->max_fd = 1;  // 파일이 들어간 fd의 최대값
 
@@ -232,6 +627,26 @@ thread_create (const char *name, int priority,
 	t->tf.cs = SEL_KCSEG;
 	t->tf.eflags = FLAG_IF;
 
+	/* Stack frame for the first switch_threads() into T, which
+	 * "returns" to switch_entry() and from there calls
+	 * kernel_thread (function, aux). */
+	struct switch_threads_frame *sf = (struct switch_threads_frame *)
+		((uint64_t) t + PGSIZE - 2 * sizeof (void *)) - 1;
+	sf->rbx = (uint64_t) kernel_thread;
+	sf->r12 = (uint64_t) function;
+	sf->r13 = (uint64_t) aux;
+	sf->rip = switch_entry;
+	t->switch_rsp = (uint64_t) sf;
+
+	// EDF thread는 생성 시점에 첫 period를 시작
+	if (period != 0) {
+		t->edf_runtime = t->edf_budget = runtime;
+		t->edf_period = period;
+		t->edf_deadline = deadline;
+		t->edf_release = timer_ticks ();
+		t->edf_abs_deadline = t->edf_release + deadline;
+	}
+
 	/* Add to run queue. */
 	thread_unblock (t);
 	test_max_priority();
@@ -239,6 +654,54 @@ thread_create (const char *name, int priority,
 	return tid;
 }
 
+/* Gives T a file descriptor table, if it does not have one yet,
+   with fds 0 and 1 open on the console.  Returns false if out of
+   memory. */
+bool
+thread_alloc_fdt (struct thread *t) {
+	enum intr_level old_level;
+	struct file **fdt;
+
+	if (t->fdt != NULL)
+		return true;
+
+	old_level = intr_disable ();
+	fdt = fdt_cache_cnt > 0 ? fdt_cache[--fdt_cache_cnt] : NULL;
+	intr_set_level (old_level);
+	if (fdt == NULL)
+		fdt = palloc_get_multiple (PAL_ZERO, FDT_PAGE_CNT);
+	if (fdt == NULL)
+		return false;
+
+	fdt[0] = FDT_STDIN;
+	fdt[1] = FDT_STDOUT;
+	t->fdt = fdt;
+	return true;
+}
+
+/* Frees T's file descriptor table, if any.  Every file in it must
+   already have been closed. */
+void
+thread_free_fdt (struct thread *t) {
+	enum intr_level old_level;
+
+	if (t->fdt == NULL)
+		return;
+
+	// 닫힌 fd는 NULL이지만, 0과 1이 열린 채 남았을 수 있으므로 사용한 범위를 비움
+	memset (t->fdt, 0, (t->max_fd + 1) * sizeof *t->fdt);
+	old_level = intr_disable ();
+	if (fdt_cache_cnt < FDT_CACHE_MAX) {
+		fdt_cache[fdt_cache_cnt++] = t->fdt;
+		t->fdt = NULL;
+	}
+	intr_set_level (old_level);
+	if (t->fdt != NULL) {
+		palloc_free_multiple (t->fdt, FDT_PAGE_CNT);
+		t->fdt = NULL;
+	}
+}
+
 /* Puts the current thread to sleep.  It will not be scheduled
    again until awoken by thread_unblock().
 
@@ -250,6 +713,7 @@ thread_block (void) {
 	ASSERT (!intr_context ());
 	ASSERT (intr_get_level () == INTR_OFF);
 	thread_current ()->status = THREAD_BLOCKED;
+	trace (TRACE_BLOCK, thread_current (), 0);
 	schedule ();
 }
 
@@ -270,11 +734,19 @@ thread_unblock (struct thread *t) {
 	old_level = intr_disable ();
 	ASSERT (t->status == THREAD_BLOCKED);
 
-	// unblock될 때 우선순위를 정렬되어 ready_list에 스레드를 추가할 수 있게
-	// list_push_back (&ready_list, &t->elem);
-	list_insert_ordered (&ready_list, &t->elem, thread_compare_priority, 0);
+	// fair scheduler: 오래 잠들어 있던 thread가 CPU를 독점하지 않도록 vruntime을 끌어올리되,
+	// 깨어난 thread가 곧바로 실행될 수 있도록 FAIR_SLEEPER_CREDIT 만큼은 앞서게 해줌
+	if (thread_fair && t->vruntime < fair_min_vruntime - FAIR_SLEEPER_CREDIT)
+		t->vruntime = fair_min_vruntime - FAIR_SLEEPER_CREDIT;
+	// stride scheduler: 잠들어 있던 동안의 pass를 몰아서 쓰지 못하도록 끌어올림
+	if (thread_stride && t->pass < stride_min_pass)
+		t->pass = stride_min_pass;
+
+	// unblock될 때 thread의 priority에 해당하는 run queue의 맨 뒤에 추가 (O(1))
+	ready_queue_push (t);
 
 	t->status = THREAD_READY;
+	trace (TRACE_UNBLOCK, t, intr_context () ? 0 : thread_current ()->tid);
 	intr_set_level (old_level);
 }
 
@@ -321,6 +793,12 @@ thread_exit (void) {
 	/* Just set our status to dying and schedule another process.
 	   We will be destroyed during the call to schedule_tail(). */
 	intr_disable ();
+	trace (TRACE_EXIT, thread_current (), 0);
+	list_remove (&thread_current ()->all_elem);
+	// EDF thread가 사용하던 대역폭을 반환
+	if (thread_current ()->edf_period != 0)
+		edf_bw -= edf_bandwidth (thread_current ()->edf_runtime,
+				thread_current ()->edf_period);
 	do_schedule (THREAD_DYING);
 	NOT_REACHED ();
 }
@@ -336,16 +814,13 @@ thread_yield (void) {
 
 	old_level = intr_disable ();
 	if (curr != idle_thread)
-	// ready_list에 삽입되는 부분을 변경해줌
-		list_insert_ordered (&ready_list, &curr->elem, thread_compare_priority, 0);
-		// list_push_back (&ready_list, &curr->elem);
+		ready_queue_push (curr);
 	do_schedule (THREAD_READY);
 	intr_set_level (old_level);
 }
 
 /* 가장 먼저 awake해야 하는 thread가 awake되어야 하는 시각을 업데이트 (setter) */
 void update_next_tick_to_awake(int64_t ticks) { 
-	// 질문: next_tick_to_awake를 초기 설정을 하지 않아도 되려나?
 	next_tick_to_awake = (next_tick_to_awake > ticks) ? ticks : next_tick_to_awake;
 }
 
@@ -357,17 +832,28 @@ int64_t get_next_tick_to_awake(void) {
 /* thread를 ticks까지 재우는 함수 */
 void thread_sleep(int64_t ticks) {
 	struct thread *cur;
-	// interrupt를 막고, 이전 interrupt 상태를 저장함
 	enum intr_level old_level;
-	old_level = intr_disable();
 
 	// 현재 thread를 잠재우기 위해 가져옴 (이 때, idle thread는 sleep되지 않아야 함)
 	cur = thread_current();
 	ASSERT(cur != idle_thread);
-	// awake 함수가 실행될 시점 tick을 update
-	update_next_tick_to_awake(cur->wakeup_tick = ticks);
-	// 현재 thread를 sleep_list에 삽입함
-	list_push_back(&sleep_list, &cur->elem);
+
+	// interrupt를 막고, 이전 interrupt 상태를 저장함
+	// - sleep heap이 가득 찬 경우, interrupt를 켠 상태에서 heap을 늘린 뒤 다시 시도
+	for (;;) {
+		old_level = intr_disable();
+		if (sleep_heap_cnt < sleep_heap_cap)
+			break;
+		size_t cap = sleep_heap_cap;
+		intr_set_level(old_level);
+		sleep_heap_grow(cap);
+	}
+	// 현재 thread를 sleep heap에 삽입함 (O(log n))
+	cur->wakeup_tick = ticks;
+	sleep_heap_push(cur);
+	trace (TRACE_SLEEP, cur, ticks);
+	// awake 함수가 실행될 시점 tick을 update (heap의 root가 가장 빠른 시점)
+	next_tick_to_awake = sleep_heap[0].wakeup_tick;
 	// 현재 thread의 상태를 block으로 변경 (scheduling까지 진행)
 	thread_block();
 
@@ -375,34 +861,115 @@ void thread_sleep(int64_t ticks) {
 	intr_set_level(old_level);
 }
 
-/* sleep_list에서 깨워야 하는 thread들을 모두 깨움 */
+/* sleep heap에서 깨워야 하는 thread들을 THREAD_AWAKE_BATCH개까지 깨움
+   - heap의 root만 확인하면 되므로 깨우는 thread 하나 당 O(log n)
+   - 더 남았다면 next_tick_to_awake가 CURR_TICK 이하로 남으므로 다시 호출하면 됨 */
 void thread_awake(int64_t curr_tick) {
-	// next_tick_to_awake를 최대값으로 설정
-	next_tick_to_awake = INT64_MAX;
-	// sleep_list에 있는 첫 번째 thread로 e 초기 설정 (정확히는 첫 번째 thread의 elem)
-	struct list_elem *e;
-	e = list_begin(&sleep_list);
-	// e가 thread의 끝(tail)에 닿을 때까지 순서대로 확인
-	while (e != list_end(&sleep_list)) {
-		// e로 thread의 주소값 확보
-		struct thread *t = list_entry(e, struct thread, elem);
-		// thread가 일어나야할 시점이 현재 시점보다 작거나 같은 경우,
-		// 즉 thread가 일어나야할 시점에 이른 경우
-		if (curr_tick >= t-> wakeup_tick) {
-			// 해당 thread를 sleep_list에서 제거
-			e = list_remove(&t->elem);
-			// 해당 thread의 상태를 ready로 바꾸고 ready_list에 추가
-			thread_unblock(t);
-		} 
-		// thread가 아직 일어나야할 시점이 아닌 경우
-		else {
-			// e를 다음 thread로 변경
-			e = list_next(e);
-			// 해당 thread의 일어나야할 시점으로 next_tick_to_awake 업데이트
-			update_next_tick_to_awake(t->wakeup_tick);
-		}
+	ASSERT (intr_get_level () == INTR_OFF);
+
+	// interrupt를 끈 시간이 길어지지 않도록 한 번에 THREAD_AWAKE_BATCH개까지만 깨움
+	for (int i = 0; i < THREAD_AWAKE_BATCH && sleep_heap_cnt > 0
+			&& sleep_heap[0].wakeup_tick <= curr_tick; i++) {
+		struct thread *t = sleep_heap_pop ();
+		trace (TRACE_WAKE, t, curr_tick);
+		thread_unblock (t);
 	}
+	// 새 period를 시작한 EDF thread가 있다면 곧바로 실행되도록 양보
+	if (intr_context () && !rb_empty (&edf_tree)
+			&& ready_queue_preempts (thread_current ()))
+		intr_yield_on_return ();
+	// 남아 있는 thread 중 가장 빠른 시점으로 next_tick_to_awake를 정확히 유지
+	next_tick_to_awake = sleep_heap_cnt > 0 ? sleep_heap[0].wakeup_tick : INT64_MAX;
+}
+
+/* sleep heap의 두 entry를 비교: wakeup_tick이 빠른 쪽이 앞,
+   같은 tick이면 먼저 잠든 쪽이 앞 (FIFO 유지) */
+static bool
+sleep_entry_less (const struct sleep_entry *a, const struct sleep_entry *b) {
+	if (a->wakeup_tick != b->wakeup_tick)
+		return a->wakeup_tick < b->wakeup_tick;
+	return a->seq < b->seq;
+}
 
+/* T를 sleep heap에 추가 (sift-up) */
+static void
+sleep_heap_push (struct thread *t) {
+	static uint64_t next_seq;
+	size_t i = sleep_heap_cnt++;
+
+	ASSERT (intr_get_level () == INTR_OFF);
+	ASSERT (sleep_heap_cnt <= sleep_heap_cap);
+
+	struct sleep_entry new = { t->wakeup_tick, next_seq++, t };
+	while (i > 0) {
+		size_t parent = (i - 1) / 2;
+		if (!sleep_entry_less (&new, &sleep_heap[parent]))
+			break;
+		sleep_heap[i] = sleep_heap[parent];
+		i = parent;
+	}
+	sleep_heap[i] = new;
+}
+
+/* sleep heap의 root(가장 빨리 깨어나야 하는 thread)를 꺼내 반환 (sift-down) */
+static struct thread *
+sleep_heap_pop (void) {
+	ASSERT (intr_get_level () == INTR_OFF);
+	ASSERT (sleep_heap_cnt > 0);
+
+	struct thread *t = sleep_heap[0].t;
+	struct sleep_entry last = sleep_heap[--sleep_heap_cnt];
+	size_t i = 0;
+	for (;;) {
+		size_t child = 2 * i + 1;
+		if (child >= sleep_heap_cnt)
+			break;
+		if (child + 1 < sleep_heap_cnt
+				&& sleep_entry_less (&sleep_heap[child + 1], &sleep_heap[child]))
+			child++;
+		if (!sleep_entry_less (&sleep_heap[child], &last))
+			break;
+		sleep_heap[i] = sleep_heap[child];
+		i = child;
+	}
+	if (sleep_heap_cnt > 0)
+		sleep_heap[i] = last;
+	return t;
+}
+
+/* sleep heap의 크기가 OLD_CAP일 때 두 배로 늘림
+   - palloc이 sleep할 수 있으므로 interrupt가 켜진 상태에서 호출되어야 함
+   - 그 사이 다른 thread가 먼저 늘렸다면 새로 받은 공간은 반납 */
+static void
+sleep_heap_grow (size_t old_cap) {
+	// page 하나에 entry가 딱 나누어 떨어지지 않으므로 cap이 아닌 page 수를 따로 기록해 둠
+	size_t new_pages = old_cap > 0 ? sleep_heap_pages * 2 : 1;
+	size_t old_pages;
+	struct sleep_entry *new_heap, *old_heap;
+	enum intr_level old_level;
+
+	ASSERT (intr_get_level () == INTR_ON);
+
+	new_heap = palloc_get_multiple (0, new_pages);
+	if (new_heap == NULL)
+		PANIC ("thread_sleep: out of memory for sleep heap");
+
+	old_level = intr_disable ();
+	if (sleep_heap_cap == old_cap) {
+		memcpy (new_heap, sleep_heap, sleep_heap_cnt * sizeof *sleep_heap);
+		old_heap = sleep_heap;
+		old_pages = sleep_heap_pages;
+		sleep_heap = new_heap;
+		sleep_heap_pages = new_pages;
+		sleep_heap_cap = new_pages * PGSIZE / sizeof *sleep_heap;
+	} else {
+		old_heap = new_heap;
+		old_pages = new_pages;
+	}
+	intr_set_level (old_level);
+
+	if (old_heap != NULL)
+		palloc_free_multiple (old_heap, old_pages);
 }
 
 /* 우선순위를 정렬하기 위해 비교함수 정의 */
@@ -412,86 +979,223 @@ thread_compare_priority (const struct list_elem *a, const struct list_elem *b, v
 			> list_entry (b, struct thread, elem)->priority;
 }
 
-/* donations를 우선순위 기준으로 정렬하기 위한 비교 함수 정의 */
-bool
-thread_compare_donate_priority (const struct list_elem *a, const struct list_elem *b, void *aux UNUSED) {
-	return list_entry (a, struct thread, donation_elem) -> priority 
-			> list_entry (b, struct thread, donation_elem)-> priority;
+/* held_locks의 정렬 기준: lock을 기다리는 thread들의 최고 priority가 높은 lock이 앞 */
+static bool
+held_lock_less (const struct rb_elem *a, const struct rb_elem *b,
+		void *aux UNUSED) {
+	return rb_entry (a, struct lock, held_elem)->priority
+			> rb_entry (b, struct lock, held_elem)->priority;
 }
 
-/* ready_list에서 가장 높은 우선순위를 가진 스레드(head)가 현재 current_thread(CPU 점유중인)인 스레드보다 높으면
+/* run queue에서 가장 높은 우선순위를 가진 스레드가 현재 current_thread(CPU 점유중인)인 스레드보다 높으면
 	CPU점유를 양보하는 함수 */
-// test_max_priority 함수는 스레드가 새로 생성돼서 ready_list에 추가되거나 현재 실행중인 스레드의 우선순위가 재조정될 때 호출
+// test_max_priority 함수는 스레드가 새로 생성돼서 run queue에 추가되거나 현재 실행중인 스레드의 우선순위가 재조정될 때 호출
 // 즉, 스레드를 새로 생성하는 함수인 thread_create에서 현재 스레드의 우선순위를 재조정하는 thread_set_priority() 내부에 test_max_priority()를 추가
 void
 test_max_priority (void) {
-	if (!intr_context() 
-		&& !list_empty (&ready_list) 
-		&& thread_current()->priority < list_entry(list_front(&ready_list), struct thread, elem)->priority){
+	if (!intr_context() && ready_queue_preempts (thread_current ())){
 		thread_yield();
 	}
 }
 
-/* current thread를 시작으로 필요한 범위까지 우선순위를 양도 */
+/* LOCK을 기다리는 thread 중 가장 높은 priority로 lock->priority를 갱신
+   - lock이 holder의 held_locks에 들어 있다면 위치를 다시 잡아줌
+   - 값이 바뀌었으면 true를 반환 */
+static bool
+lock_update_priority (struct lock *lock) {
+	int priority = PRI_MIN;
+
+	if (!rb_empty (&lock->donors))
+		priority = rb_entry (rb_min (&lock->donors), struct thread, donor_elem)->priority;
+	if (priority == lock->priority)
+		return false;
+
+	if (lock->holder != NULL) {
+		rb_remove (&lock->holder->held_locks, &lock->held_elem);
+		lock->priority = priority;
+		rb_insert (&lock->holder->held_locks, &lock->held_elem);
+	} else
+		lock->priority = priority;
+	return true;
+}
+
+/* T의 priority를 PRIORITY로 바꾸고, priority 순서로 정렬된 run queue와
+   condition variable의 waiters에 T가 들어 있다면 위치를 다시 잡아줌 */
+static void
+requeue_with_priority (struct thread *t, int priority) {
+	if (t->status == THREAD_READY)
+		ready_queue_remove (t);
+	if (t->wait_on_cond != NULL)
+		rb_remove (&t->wait_on_cond->waiters, &t->cond_elem);
+	t->priority = priority;
+	if (t->wait_on_cond != NULL)
+		rb_insert (&t->wait_on_cond->waiters, &t->cond_elem);
+	if (t->status == THREAD_READY)
+		ready_queue_push (t);
+}
+
+/* T의 priority를 init_priority, T가 가진 lock들이 받은 donation, read_boost 중 높은 값으로 다시 계산
+   - 값이 바뀌었다면 T가 기다리는 lock의 holder에게, 다시 그 holder가 기다리는 lock의
+     holder에게 차례로 전파함 (깊이 제한 없음)
+   - 각 단계는 held_locks, donors, run queue에서 위치를 다시 잡는 O(log n) 작업 */
+static void
+propagate_priority (struct thread *t) {
+	ASSERT (intr_get_level () == INTR_OFF);
+
+	for (;;) {
+		struct lock *lock = t->wait_on_lock;
+		int priority = t->init_priority;
+		int old_priority;
+
+		if (t->read_boost > priority)
+			priority = t->read_boost;
+		if (!rb_empty (&t->held_locks)) {
+			struct lock *top = rb_entry (rb_min (&t->held_locks), struct lock, held_elem);
+			if (top->priority > priority)
+				priority = top->priority;
+		}
+		if (priority == t->priority)
+			return;
+
+		// T가 들어 있는 자료구조(lock의 donors, run queue)는 priority 순서이므로 빼고 다시 넣음
+		if (lock != NULL)
+			rb_remove (&lock->donors, &t->donor_elem);
+		old_priority = t->priority;
+		requeue_with_priority (t, priority);
+		// event의 priority 칸에 바뀐 뒤의 값이 남도록 requeue 이후에 기록
+		trace (TRACE_DONATE, t, old_priority);
+		if (lock == NULL) {
+			// reader들이 빠져나가기를 기다리는 writer라면 reader들에게 전파
+			if (t->drain_rwlock != NULL)
+				donate_priority_to_readers (t->drain_rwlock);
+			return;
+		}
+		rb_insert (&lock->donors, &t->donor_elem);
+
+		// lock이 받는 donation이 바뀌었다면 holder로 초점 이동
+		if (!lock_update_priority (lock) || lock->holder == NULL)
+			return;
+		t = lock->holder;
+	}
+}
+
+/* current thread가 wait_on_lock의 donors에 추가된 뒤 호출되어,
+   lock의 holder부터 시작해 필요한 범위까지 우선순위를 양도 */
 void
 donate_priority (void) {
+	struct lock *lock = thread_current ()->wait_on_lock;
+
+	ASSERT (intr_get_level () == INTR_OFF);
+	ASSERT (lock != NULL);
+
+	// stride scheduler에서는 priority 대신 tickets를 빌려줌
+	if (thread_stride) {
+		stride_lend (lock, stride_tickets (thread_current ()));
+		return;
+	}
+	if (lock_update_priority (lock) && lock->holder != NULL)
+		propagate_priority (lock->holder);
+}
+
+/* current thread가 LOCK을 획득한 시점에 실행됨
+   - LOCK을 기다리다 얻었다면 donors에서 빠지고 wait_on_lock 초기화
+   - 아직 LOCK을 기다리는 thread들의 donation을 이어받도록 held_locks에 추가 */
+void
+add_held_lock (struct lock *lock) {
 	struct thread *curr = thread_current ();
-	int depth;
-	// 최대 DONATE_MAX_DEPTH 까지 우선순위를 양도 
-	for (depth = 0; depth < DONATE_MAX_DEPTH; depth++) {
-		// thread가 기다리는 lock이 있는지 확인
-		if (!curr->wait_on_lock) break;
-		// 기다리는 lock의 holder를 찾아, holder의 우선순위를 업데이트
-		// - 이 때, holder의 우선순위 보다 현재 thread의 우선순위가 높은 경우에만 업데이트 필요
-		struct thread *holder = curr->wait_on_lock->holder;
-		if (holder->priority < curr->priority) {
-			holder->priority = curr->priority;
-		}
-		// holder를 curr로 업데이트해 초점 이동
-		curr = holder;
+
+	ASSERT (intr_get_level () == INTR_OFF);
+	ASSERT (lock->holder == curr);
+
+	if (curr->wait_on_lock == lock) {
+		rb_remove (&lock->donors, &curr->donor_elem);
+		curr->wait_on_lock = NULL;
+		// stride scheduler: LOCK의 tickets는 항상 donors가 빌려준 tickets의 합이므로
+		// 빌려줬던 만큼만 빼면 남은 donors의 합이 됨 (donors를 다시 세지 않음)
+		if (thread_stride)
+			lock->tickets -= stride_tickets (curr);
+	}
+	lock->priority = PRI_MIN;
+	// stride scheduler: 남은 donors가 빌려준 tickets를 이어받음
+	if (thread_stride) {
+		rb_insert (&curr->held_locks, &lock->held_elem);
+		curr->donated_tickets += lock->tickets;
+		return;
 	}
+	if (!rb_empty (&lock->donors))
+		lock->priority = rb_entry (rb_min (&lock->donors), struct thread, donor_elem)->priority;
+	rb_insert (&curr->held_locks, &lock->held_elem);
+	propagate_priority (curr);
 }
 
-/* current thread의 donations에서 lock이 반환되기를 기다리고 있던 thread를 제거
+/* current thread의 held_locks에서 LOCK을 제거 (LOCK이 받던 donation도 함께 사라짐)
 - 이 함수는 current thread가 lock을 release하는 시점에 실행됨 */
 void
 remove_with_lock (struct lock *lock) {
+	ASSERT (intr_get_level () == INTR_OFF);
+	ASSERT (lock->holder == thread_current ());
+
+	rb_remove (&thread_current ()->held_locks, &lock->held_elem);
+	if (thread_stride)
+		thread_current ()->donated_tickets -= lock->tickets;
+}
+
+/* T의 read_boost를 T가 read lock을 가진 rwlock들에서 기다리는 writer의 최고 priority로 갱신 */
+static void
+update_read_boost (struct thread *t) {
+	int boost = PRI_MIN;
 	struct list_elem *e;
-	struct thread *curr = thread_current ();
-	// 현재 thread의 donations들 중 반환할 lock을 기다리고 있던 thread를 삭제
-	for (e = list_begin (&curr->donations); 
-		e != list_end (&curr->donations); 
-		e = list_next (e)) {
-			struct thread *t = list_entry (e, struct thread, donation_elem);
-			if (t->wait_on_lock == lock) {
-				list_remove (&t->donation_elem);
-			}
+
+	for (e = list_begin (&t->read_holds); e != list_end (&t->read_holds);
+			e = list_next (e)) {
+		struct rwlock *rw = list_entry (e, struct rwlock_hold, thread_elem)->rwlock;
+		if (rw->drainer != NULL && rw->drainer->priority > boost)
+			boost = rw->drainer->priority;
+	}
+	t->read_boost = boost;
+}
+
+/* RW의 reader들이 빠져나가기를 기다리는 writer(RW->drainer)의 priority를
+   RW의 read lock을 가진 모든 thread에게 양도 */
+void
+donate_priority_to_readers (struct rwlock *rw) {
+	struct list_elem *e;
+
+	ASSERT (intr_get_level () == INTR_OFF);
+
+	for (e = list_begin (&rw->read_holds); e != list_end (&rw->read_holds);
+			e = list_next (e)) {
+		struct thread *reader = list_entry (e, struct rwlock_hold, elem)->holder;
+		update_read_boost (reader);
+		propagate_priority (reader);
 	}
 }
 
+/* current thread가 read lock을 놓은 뒤, 남은 read lock들을 기준으로 read_boost를 다시 계산 */
+void
+refresh_read_boost (void) {
+	ASSERT (intr_get_level () == INTR_OFF);
+
+	update_read_boost (thread_current ());
+	propagate_priority (thread_current ());
+}
+
 /* current thread의 우선순위를 업데이트하는 함수 
- - 본래의 priority와 donations에 있는 우선순위 중 높은 값으로 업데이트 */
+ - 본래의 priority와 held_locks가 받은 donation 중 높은 값으로 업데이트 */
 void
 refresh_priority(void) {
-	struct thread *curr = thread_current ();
-	// 본래의 priority로 1차 업데이트
-	curr->priority = curr->init_priority;
-	// donations 중 우선순위가 가장 높은 thread의 우선순위와 비교하여 2차 업데이트
-	if (!list_empty (&curr->donations)) {
-		// donations을 우선순위 높은 순으로 정렬해 begin의 우선순위 확인 
-		// - 질문: 이미 추가할 때마다 순서를 유지하고 있는데 꼭 해야할까? 
-		//       혹은 어차피 여기서 정렬할거면, 그냥 넣을 때는 맨 뒤에 넣으면 되지 않을까?
-		list_sort (&curr->donations, thread_compare_donate_priority, 0); 
-		struct thread *front = list_entry(list_front (&curr->donations), struct thread, donation_elem);
-		if (front->priority > curr->priority) {
-			curr->priority = front->priority;
-		}
-	}
+	enum intr_level old_level = intr_disable ();
+	propagate_priority (thread_current ());
+	intr_set_level (old_level);
 }
 
 /* Sets the current thread's priority to NEW_PRIORITY. */
 void
 thread_set_priority (int new_priority) {
+	// MLFQS에서는 scheduler가 priority를 직접 관리함
+	if (thread_mlfqs)
+		return;
+
 	// current thread의 priority는 donation에 의해 수정된 상태일 수 있으므로
 	// priority가 아닌 init_priority를 업데이트
 	thread_current ()->init_priority = new_priority;
@@ -506,31 +1210,147 @@ thread_get_priority (void) {
 	return thread_current ()->priority;
 }
 
-/* Sets the current thread's nice value to NICE. */
+/* Sets the current thread's own number of stride-scheduler
+   tickets to TICKETS, clamped to [STRIDE_TICKETS_MIN,
+   STRIDE_TICKETS_MAX].  Threads it creates start with the same
+   number. */
 void
-thread_set_nice (int nice UNUSED) {
-	/* TODO: Your implementation goes here */
+thread_set_tickets (int tickets) {
+	if (tickets < STRIDE_TICKETS_MIN)
+		tickets = STRIDE_TICKETS_MIN;
+	else if (tickets > STRIDE_TICKETS_MAX)
+		tickets = STRIDE_TICKETS_MAX;
+
+	// 실행 중인 thread는 lock을 기다리고 있지 않으므로 다른 thread에 전파할 필요 없음
+	enum intr_level old_level = intr_disable ();
+	thread_current ()->tickets = tickets;
+	intr_set_level (old_level);
+}
+
+/* Returns the current thread's tickets, including those lent by
+   threads waiting on locks it holds. */
+int
+thread_get_tickets (void) {
+	enum intr_level old_level = intr_disable ();
+	int tickets = stride_tickets (thread_current ());
+	intr_set_level (old_level);
+	return tickets;
+}
+
+/* Sets the current thread's nice value to NICE and recomputes
+   its priority.  Yields if it no longer has the highest
+   priority. */
+void
+thread_set_nice (int nice) {
+	enum intr_level old_level;
+
+	ASSERT (NICE_MIN <= nice && nice <= NICE_MAX);
+
+	old_level = intr_disable ();
+	thread_current ()->nice = nice;
+	mlfqs_update_priority (thread_current ());
+	intr_set_level (old_level);
+	test_max_priority ();
 }
 
 /* Returns the current thread's nice value. */
 int
 thread_get_nice (void) {
-	/* TODO: Your implementation goes here */
-	return 0;
+	return thread_current ()->nice;
 }
 
 /* Returns 100 times the system load average. */
 int
 thread_get_load_avg (void) {
-	/* TODO: Your implementation goes here */
-	return 0;
+	enum intr_level old_level = intr_disable ();
+	int load_avg_100 = fp_to_int_round (fp_mul_int (load_avg, 100));
+	intr_set_level (old_level);
+	return load_avg_100;
 }
 
 /* Returns 100 times the current thread's recent_cpu value. */
 int
 thread_get_recent_cpu (void) {
-	/* TODO: Your implementation goes here */
-	return 0;
+	enum intr_level old_level = intr_disable ();
+	int recent_cpu_100 =
+		fp_to_int_round (fp_mul_int (thread_current ()->recent_cpu, 100));
+	intr_set_level (old_level);
+	return recent_cpu_100;
+}
+
+/* MLFQS bookkeeping for one timer tick, with T running.
+   Only the running thread's recent_cpu grows on a tick, so only
+   its priority can change between the once-per-second updates;
+   the other threads are recomputed only when load_avg decays
+   their recent_cpu. */
+static void
+mlfqs_tick (struct thread *t) {
+	int64_t now = timer_ticks ();
+
+	ASSERT (intr_context ());
+
+	if (t != idle_thread)
+		t->recent_cpu = fp_add_int (t->recent_cpu, 1);
+
+	if (now % TIMER_FREQ == 0) {
+		struct list_elem *e;
+
+		mlfqs_update_load_avg ();
+		for (e = list_begin (&all_list); e != list_end (&all_list);
+				e = list_next (e)) {
+			struct thread *u = list_entry (e, struct thread, all_elem);
+			if (u == idle_thread)
+				continue;
+			mlfqs_update_recent_cpu (u);
+			mlfqs_update_priority (u);
+		}
+	} else if (now % 4 == 0 && t != idle_thread)
+		mlfqs_update_priority (t);
+
+	// priority가 바뀌어 더 높은 priority의 thread가 ready 상태라면 양보
+	if (ready_queue_preempts (t))
+		intr_yield_on_return ();
+}
+
+/* priority = PRI_MAX - (recent_cpu / 4) - (nice * 2), clamped to
+   [PRI_MIN, PRI_MAX].  Moves T to its new run queue if it is
+   ready. */
+static void
+mlfqs_update_priority (struct thread *t) {
+	int priority;
+
+	ASSERT (intr_get_level () == INTR_OFF || t->status != THREAD_READY);
+
+	priority = PRI_MAX - fp_to_int_round (fp_div_int (t->recent_cpu, 4))
+		- t->nice * 2;
+	if (priority < PRI_MIN)
+		priority = PRI_MIN;
+	else if (priority > PRI_MAX)
+		priority = PRI_MAX;
+
+	if (priority == t->priority)
+		return;
+	requeue_with_priority (t, priority);
+}
+
+/* recent_cpu = (2 * load_avg) / (2 * load_avg + 1) * recent_cpu + nice. */
+static void
+mlfqs_update_recent_cpu (struct thread *t) {
+	fixed_t twice_load = fp_mul_int (load_avg, 2);
+	fixed_t coeff = fp_div (twice_load, fp_add_int (twice_load, 1));
+
+	t->recent_cpu = fp_add_int (fp_mul (coeff, t->recent_cpu), t->nice);
+}
+
+/* load_avg = (59/60) * load_avg + (1/60) * ready_threads, where
+   ready_threads counts the running thread (unless idle) and the
+   threads in the run queues. */
+static void
+mlfqs_update_load_avg (void) {
+	int ready_threads = ready_cnt + (thread_current () != idle_thread);
+
+	load_avg = fp_add (fp_div_int (fp_mul_int (load_avg, 59), 60),
+			fp_div_int (int_to_fp (ready_threads), 60));
 }
 
 /* Idle thread.  Executes when no other thread is ready to run.
@@ -552,8 +1372,13 @@ idle (void *idle_started_ UNUSED) {
 	for (;;) {
 		/* Let someone else run. */
 		intr_disable ();
+		timer_idle_exit ();
 		thread_block ();
 
+		/* With tickless idle, skip timer ticks until the next
+		   sleeping thread has to be woken up. */
+		timer_idle_enter ();
+
 		/* Re-enable interrupts and wait for the next one.
 
 		   The `sti' instruction disables interrupts until the
@@ -599,7 +1424,24 @@ init_thread (struct thread *t, const char *name, int priority) {
 	// donation 관련 멤버 초기 설정
 	t->init_priority = priority;  // 변하지 않고, 변경된 priority를 되돌릴 때 사용됨
 	t->wait_on_lock = NULL;	       
-	list_init (&t->donations);
+	rb_init (&t->held_locks, held_lock_less, NULL);
+	t->read_boost = PRI_MIN;
+	t->drain_rwlock = NULL;
+	list_init (&t->read_holds);
+	t->wait_on_cond = NULL;
+
+	// MLFQS 관련 멤버 초기 설정 (thread_create에서 부모 값을 물려받음)
+	t->nice = NICE_DEFAULT;
+	t->recent_cpu = 0;
+
+	// stride scheduler 관련 멤버 초기 설정 (thread_create에서 부모의 tickets를 물려받음)
+	t->tickets = STRIDE_TICKETS_DEFAULT;
+	t->donated_tickets = 0;
+	t->pass = 0;
+	// all_list는 timer interrupt에서도 순회하므로 interrupt를 막고 추가
+	enum intr_level old_level = intr_disable ();
+	list_push_back (&all_list, &t->all_elem);
+	intr_set_level (old_level);
 
 	/* parent child 관계 관련 */
 	list_init(&t->children);		/* children list 생성 */
@@ -618,10 +1460,259 @@ init_thread (struct thread *t, const char *name, int priority) {
    idle_thread. */
 static struct thread *
 next_thread_to_run (void) {
-	if (list_empty (&ready_list))
+	if (ready_cnt == 0)
 		return idle_thread;
 	else
-		return list_entry (list_pop_front (&ready_list), struct thread, elem);
+		return ready_queue_pop ();
+}
+
+/* T를 T의 priority에 해당하는 run queue의 맨 뒤에 추가하고 mask에 표시
+   - 같은 priority끼리는 FIFO 순서가 유지됨 (priority-fifo) */
+static void
+ready_queue_push (struct thread *t) {
+	ASSERT (intr_get_level () == INTR_OFF);
+	ASSERT (PRI_MIN <= t->priority && t->priority <= PRI_MAX);
+
+	if (edf_queued (t))
+		rb_insert (&edf_tree, &t->edf_elem);
+	else if (thread_fair) {
+		rb_insert (&fair_tree, &t->fair_elem);
+		fair_load += fair_weight (t->priority);
+	} else if (thread_stride)
+		rb_insert (&stride_tree, &t->stride_elem);
+	else {
+		list_push_back (&ready_queues[t->priority], &t->elem);
+		ready_mask |= 1ULL << t->priority;
+	}
+	ready_cnt++;
+}
+
+/* run queue에 들어 있는 T를 제거 (priority가 바뀌는 경우 등) */
+static void
+ready_queue_remove (struct thread *t) {
+	ASSERT (intr_get_level () == INTR_OFF);
+	ASSERT (t->status == THREAD_READY);
+
+	if (edf_queued (t))
+		rb_remove (&edf_tree, &t->edf_elem);
+	else if (thread_fair) {
+		rb_remove (&fair_tree, &t->fair_elem);
+		fair_load -= fair_weight (t->priority);
+	} else if (thread_stride)
+		rb_remove (&stride_tree, &t->stride_elem);
+	else {
+		list_remove (&t->elem);
+		if (list_empty (&ready_queues[t->priority]))
+			ready_mask &= ~(1ULL << t->priority);
+	}
+	ready_cnt--;
+}
+
+/* 가장 높은 priority의 run queue에서 맨 앞의 thread를 꺼내 반환
+   - run queue가 모두 비어 있으면 안 됨 */
+static struct thread *
+ready_queue_pop (void) {
+	// deadline이 가장 빠른 EDF thread가 있다면 가장 먼저 실행
+	if (!rb_empty (&edf_tree)) {
+		struct thread *t = rb_entry (rb_min (&edf_tree), struct thread, edf_elem);
+		ready_queue_remove (t);
+		return t;
+	}
+	if (thread_fair) {
+		struct thread *t = rb_entry (rb_min (&fair_tree), struct thread, fair_elem);
+		ready_queue_remove (t);
+		return t;
+	}
+	if (thread_stride) {
+		struct thread *t = rb_entry (rb_min (&stride_tree), struct thread, stride_elem);
+		ready_queue_remove (t);
+		return t;
+	}
+
+	int pri = ready_queue_max_priority ();
+	struct list *queue = &ready_queues[pri];
+	struct thread *t = list_entry (list_pop_front (queue), struct thread, elem);
+
+	if (list_empty (queue))
+		ready_mask &= ~(1ULL << pri);
+	ready_cnt--;
+	return t;
+}
+
+/* 비어있지 않은 run queue 중 가장 높은 priority (mask의 최상위 bit) */
+static int
+ready_queue_max_priority (void) {
+	ASSERT (ready_mask != 0);
+	return 63 - __builtin_clzll (ready_mask);
+}
+
+/* run queue의 맨 앞 thread가 CURR보다 먼저 실행되어야 하는지 여부
+   - EDF: deadline이 더 빠른 EDF thread가 ready 상태인 경우 (EDF thread는 항상 일반 thread보다 앞섬)
+   - priority scheduler: 더 높은 priority의 thread가 ready 상태인 경우
+   - fair scheduler: vruntime이 FAIR_WAKEUP_GRANULARITY 이상 뒤처진 thread가 있는 경우
+   - stride scheduler: pass가 더 작은 thread가 있는 경우 */
+static bool
+ready_queue_preempts (struct thread *curr) {
+	if (ready_cnt == 0)
+		return false;
+	if (!rb_empty (&edf_tree)) {
+		struct thread *t = rb_entry (rb_min (&edf_tree), struct thread, edf_elem);
+		return !edf_queued (curr) || t->edf_abs_deadline < curr->edf_abs_deadline;
+	}
+	if (edf_queued (curr))
+		return false;
+	if (thread_fair) {
+		struct thread *t = rb_entry (rb_min (&fair_tree), struct thread, fair_elem);
+		return t->vruntime + FAIR_WAKEUP_GRANULARITY < curr->vruntime;
+	}
+	if (thread_stride) {
+		struct thread *t = rb_entry (rb_min (&stride_tree), struct thread, stride_elem);
+		return t->pass < curr->pass;
+	}
+	return curr->priority < ready_queue_max_priority ();
+}
+
+/* Returns true if T is scheduled in the EDF class: a real-time
+   thread with budget left in its current period. */
+static bool
+edf_queued (const struct thread *t) {
+	return t->edf_period != 0 && !t->edf_throttled;
+}
+
+/* Returns RUNTIME / PERIOD in EDF_BW_SHIFT-bit fixed point. */
+static int64_t
+edf_bandwidth (int64_t runtime, int64_t period) {
+	return (runtime << EDF_BW_SHIFT) / period;
+}
+
+/* edf_tree의 정렬 기준: 현재 job의 deadline이 빠른 thread가 앞 */
+static bool
+edf_less (const struct rb_elem *a_, const struct rb_elem *b_,
+		void *aux UNUSED) {
+	const struct thread *a = rb_entry (a_, struct thread, edf_elem);
+	const struct thread *b = rb_entry (b_, struct thread, edf_elem);
+
+	return a->edf_abs_deadline < b->edf_abs_deadline;
+}
+
+/* Returns the fair-scheduler weight of a thread with PRIORITY.
+   Each priority level above PRI_DEFAULT is worth about 25% more
+   CPU time than the one below it, as in the nice-to-weight table
+   of Linux's CFS; levels more than 20 away from PRI_DEFAULT are
+   clamped. */
+static int
+fair_weight (int priority) {
+	static const int weights[40] = {
+		/* -20 */ 88761, 71755, 56483, 46273, 36291,
+		/* -15 */ 29154, 23254, 18705, 14949, 11916,
+		/* -10 */ 9548, 7620, 6100, 4904, 3906,
+		/*  -5 */ 3121, 2501, 1991, 1586, 1277,
+		/*   0 */ 1024, 820, 655, 526, 423,
+		/*   5 */ 335, 272, 215, 172, 137,
+		/*  10 */ 110, 87, 70, 56, 45,
+		/*  15 */ 36, 29, 23, 18, 15,
+	};
+	int nice = PRI_DEFAULT - priority;
+
+	if (nice < -20)
+		nice = -20;
+	else if (nice > 19)
+		nice = 19;
+	return weights[nice + 20];
+}
+
+/* fair_tree의 정렬 기준: vruntime이 작은 thread가 앞 */
+static bool
+fair_less (const struct rb_elem *a_, const struct rb_elem *b_,
+		void *aux UNUSED) {
+	const struct thread *a = rb_entry (a_, struct thread, fair_elem);
+	const struct thread *b = rb_entry (b_, struct thread, fair_elem);
+
+	return a->vruntime < b->vruntime;
+}
+
+/* Charges one timer tick to running thread T, scaled by its
+   weight, and advances fair_min_vruntime. */
+static void
+fair_tick (struct thread *t) {
+	int64_t min_vruntime = t->vruntime;
+
+	t->vruntime += (int64_t) FAIR_WEIGHT_DEFAULT * FAIR_WEIGHT_DEFAULT
+		/ fair_weight (t->priority);
+
+	if (!rb_empty (&fair_tree)) {
+		struct thread *first = rb_entry (rb_min (&fair_tree), struct thread, fair_elem);
+		if (first->vruntime < min_vruntime)
+			min_vruntime = first->vruntime;
+	}
+	if (min_vruntime > fair_min_vruntime)
+		fair_min_vruntime = min_vruntime;
+}
+
+/* Returns T's time slice in ticks: its weighted share of a
+   period of FAIR_LATENCY ticks, or of FAIR_MIN_GRANULARITY ticks
+   per thread when there are too many threads to fit. */
+static unsigned
+fair_slice (struct thread *t) {
+	int64_t weight = fair_weight (t->priority);
+	int64_t period = FAIR_LATENCY;
+	int64_t slice;
+
+	if (period < (ready_cnt + 1) * FAIR_MIN_GRANULARITY)
+		period = (ready_cnt + 1) * FAIR_MIN_GRANULARITY;
+	slice = period * weight / (fair_load + weight);
+	return slice > FAIR_MIN_GRANULARITY ? slice : FAIR_MIN_GRANULARITY;
+}
+
+/* Returns T's tickets, its own plus those lent to it. */
+static int64_t
+stride_tickets (const struct thread *t) {
+	return t->tickets + t->donated_tickets;
+}
+
+/* stride_tree의 정렬 기준: pass가 작은 thread가 앞 */
+static bool
+stride_less (const struct rb_elem *a_, const struct rb_elem *b_,
+		void *aux UNUSED) {
+	const struct thread *a = rb_entry (a_, struct thread, stride_elem);
+	const struct thread *b = rb_entry (b_, struct thread, stride_elem);
+
+	return a->pass < b->pass;
+}
+
+/* Charges one timer tick to running thread T by advancing its
+   pass by its stride, and advances stride_min_pass. */
+static void
+stride_tick (struct thread *t) {
+	int64_t min_pass = t->pass;
+
+	t->pass += STRIDE1 / stride_tickets (t);
+
+	if (!rb_empty (&stride_tree)) {
+		struct thread *first = rb_entry (rb_min (&stride_tree), struct thread, stride_elem);
+		if (first->pass < min_pass)
+			min_pass = first->pass;
+	}
+	if (min_pass > stride_min_pass)
+		stride_min_pass = min_pass;
+}
+
+/* TICKETS만큼(음수면 회수) LOCK에 빌려주고, LOCK의 holder부터 holder가 기다리는
+   lock을 따라 차례로 전파함 (ticket transfer)
+   - tickets는 합으로 계산되므로 각 단계에서 더하기만 하면 됨 (O(depth)) */
+static void
+stride_lend (struct lock *lock, int64_t tickets) {
+	ASSERT (intr_get_level () == INTR_OFF);
+
+	while (lock != NULL) {
+		struct thread *holder = lock->holder;
+
+		lock->tickets += tickets;
+		if (holder == NULL)
+			break;
+		holder->donated_tickets += tickets;
+		lock = holder->wait_on_lock;
+	}
 }
 
 /* Use iretq to launch the thread */
@@ -664,6 +1755,22 @@ do_iret (struct intr_frame *tf) {
    added at the end of the function. */
 static void
 thread_launch (struct thread *th) {
+	ASSERT (intr_get_level () == INTR_OFF);
+
+	/* Both threads are in the kernel here: a thread only gives up
+	 * the CPU from inside schedule(), and user context is saved on
+	 * the kernel stack by the interrupt or syscall entry path.
+	 * So saving the callee-saved registers is enough. */
+	if (!thread_iret_switch)
+		switch_threads (&running_thread ()->switch_rsp, th->switch_rsp);
+	else
+		thread_launch_iret (th);
+}
+
+/* Switches to TH by saving the whole execution context into the
+ * running thread's intr_frame and restoring TH's with iretq. */
+static void
+thread_launch_iret (struct thread *th) {
 	uint64_t tf_cur = (uint64_t) &running_thread ()->tf;
 	uint64_t tf = (uint64_t) &th->tf;
 	ASSERT (intr_get_level () == INTR_OFF);
@@ -732,7 +1839,10 @@ do_schedule(int status) {
 	while (!list_empty (&destruction_req)) {
 		struct thread *victim =
 			list_entry (list_pop_front (&destruction_req), struct thread, elem);
-		palloc_free_page(victim);
+		if (thread_cache_cnt < THREAD_CACHE_MAX)
+			thread_cache[thread_cache_cnt++] = victim;
+		else
+			palloc_free_page(victim);
 	}
 	thread_current ()->status = status;
 	schedule ();
@@ -758,6 +1868,13 @@ schedule (void) {
 #endif
 
 	if (curr != next) {
+		// tickless idle 중 interrupt로 깨어난 thread에게 넘어가는 경우, idle이 다시 돌기 전에
+		// periodic tick을 되살려야 새 thread가 time slice와 sleeper wakeup을 받을 수 있음
+		if (curr == idle_thread)
+			timer_idle_exit ();
+		account_run_ns (curr);
+		trace (TRACE_SWITCH, next, curr->tid);
+
 		/* If the thread we switched from is dying, destroy its struct
 		   thread. This must happen late so that thread_exit() doesn't
 		   pull out the rug under itself.
@@ -780,11 +1897,12 @@ schedule (void) {
 static tid_t
 allocate_tid (void) {
 	static tid_t next_tid = 1;
+	enum intr_level old_level;
 	tid_t tid;
 
-	lock_acquire (&tid_lock);
+	old_level = spin_lock_irqsave (&tid_lock);
 	tid = next_tid++;
-	lock_release (&tid_lock);
+	spin_unlock_irqrestore (&tid_lock, old_level);
 
 	return tid;
 }
@@ -0,0 +1,239 @@
+#include "threads/workqueue.h"
+#include <debug.h>
+#include <stdio.h>
+#include <string.h>
+#include "threads/interrupt.h"
+#include "threads/malloc.h"
+#include "threads/thread.h"
+#include "devices/timer.h"
+
+/* Workqueues.
+
+   A workqueue is a list of pending work items served by a pool
+   of kernel threads.  Work may be queued from any context,
+   including interrupt handlers, because the queues are protected
+   by disabling interrupts and the workers are woken with a
+   semaphore.  Delayed work sits on a single list ordered by
+   expiry tick until the timer interrupt moves it to its queue.
+
+   A work item is pending from the time it is queued until a
+   worker takes it off the queue, just before running it.  Queuing
+   an item that is already pending does nothing, so an item runs
+   at most once per queue_work() call made while it is idle. */
+
+/* A workqueue. */
+struct workqueue {
+	char name[16];              /* Name (for worker thread names). */
+	struct list pending;        /* Work ready to run. */
+	struct semaphore work_sema; /* Counts items in PENDING. */
+	int running;                /* # of items being run right now. */
+	int flushers;               /* # of threads in flush_workqueue(). */
+	struct semaphore idle_sema; /* Upped for each flusher when idle. */
+};
+
+/* Delayed work, soonest expiry first. */
+static struct list delayed_list;
+
+static thread_func worker_thread;
+static void enqueue (struct workqueue *, struct work *);
+static bool expires_less (const struct list_elem *, const struct list_elem *,
+		void *);
+
+/* Initializes the workqueue subsystem. */
+void
+workqueue_init (void) {
+	list_init (&delayed_list);
+}
+
+/* Creates a workqueue named NAME served by THREAD_CNT kernel
+   threads running at PRIORITY.  Returns the new workqueue, or a
+   null pointer if memory or threads could not be allocated. */
+struct workqueue *
+workqueue_create (const char *name, int thread_cnt, int priority) {
+	struct workqueue *wq;
+	int i;
+
+	ASSERT (name != NULL);
+	ASSERT (thread_cnt > 0);
+	ASSERT (PRI_MIN <= priority && priority <= PRI_MAX);
+
+	wq = malloc (sizeof *wq);
+	if (wq == NULL)
+		return NULL;
+	strlcpy (wq->name, name, sizeof wq->name);
+	list_init (&wq->pending);
+	sema_init (&wq->work_sema, 0);
+	wq->running = 0;
+	wq->flushers = 0;
+	sema_init (&wq->idle_sema, 0);
+
+	for (i = 0; i < thread_cnt; i++) {
+		char thread_name[16];
+
+		snprintf (thread_name, sizeof thread_name, "%s/%d", name, i);
+		// 이미 만든 worker는 남겨둠 (적은 수라도 동작은 함)
+		if (thread_create (thread_name, priority, worker_thread, wq) == TID_ERROR) {
+			if (i == 0) {
+				free (wq);
+				return NULL;
+			}
+			break;
+		}
+	}
+	return wq;
+}
+
+/* Initializes WORK to run FUNC. */
+void
+work_init (struct work *work, work_func *func) {
+	ASSERT (work != NULL);
+	ASSERT (func != NULL);
+
+	work->func = func;
+	work->wq = NULL;
+	work->expires = 0;
+}
+
+/* Queues WORK to run on WQ.  Returns true if WORK was queued, or
+   false if it was already pending.  May be called from an
+   interrupt handler. */
+bool
+queue_work (struct workqueue *wq, struct work *work) {
+	enum intr_level old_level;
+	bool queued = false;
+
+	ASSERT (wq != NULL);
+	ASSERT (work != NULL);
+
+	old_level = intr_disable ();
+	if (work->wq == NULL) {
+		work->wq = wq;
+		enqueue (wq, work);
+		queued = true;
+	}
+	intr_set_level (old_level);
+	return queued;
+}
+
+/* Queues WORK to run on WQ once TICKS timer ticks have passed.
+   Returns true if WORK was queued, or false if it was already
+   pending.  May be called from an interrupt handler. */
+bool
+queue_delayed_work (struct workqueue *wq, struct work *work, int64_t ticks) {
+	enum intr_level old_level;
+	bool queued = false;
+
+	ASSERT (wq != NULL);
+	ASSERT (work != NULL);
+
+	if (ticks <= 0)
+		return queue_work (wq, work);
+
+	old_level = intr_disable ();
+	if (work->wq == NULL) {
+		work->wq = wq;
+		work->expires = timer_ticks () + ticks;
+		list_insert_ordered (&delayed_list, &work->elem, expires_less, NULL);
+		queued = true;
+	}
+	intr_set_level (old_level);
+	return queued;
+}
+
+/* Waits until WQ has no pending or running work.  Delayed work
+   that has not expired yet is not waited for.  Work queued while
+   we wait is waited for too, so this may not return if WQ is kept
+   continuously busy.
+
+   This function may sleep, so it must not be called within an
+   interrupt handler, nor from one of WQ's own workers. */
+void
+flush_workqueue (struct workqueue *wq) {
+	enum intr_level old_level;
+
+	ASSERT (wq != NULL);
+	ASSERT (!intr_context ());
+
+	old_level = intr_disable ();
+	while (!list_empty (&wq->pending) || wq->running > 0) {
+		wq->flushers++;
+		sema_down (&wq->idle_sema);
+	}
+	intr_set_level (old_level);
+}
+
+/* Called by the timer interrupt handler at each tick NOW to queue
+   delayed work that has expired. */
+void
+workqueue_tick (int64_t now) {
+	ASSERT (intr_get_level () == INTR_OFF);
+
+	while (!list_empty (&delayed_list)) {
+		struct work *work = list_entry (list_front (&delayed_list),
+				struct work, elem);
+		if (work->expires > now)
+			break;
+		list_pop_front (&delayed_list);
+		enqueue (work->wq, work);
+	}
+}
+
+/* Returns the tick at which the earliest delayed work expires,
+   or INT64_MAX if there is none. */
+int64_t
+workqueue_next_tick (void) {
+	ASSERT (intr_get_level () == INTR_OFF);
+
+	if (list_empty (&delayed_list))
+		return INT64_MAX;
+	return list_entry (list_front (&delayed_list), struct work, elem)->expires;
+}
+
+/* WORK를 WQ의 pending list에 넣고 worker를 하나 깨움 */
+static void
+enqueue (struct workqueue *wq, struct work *work) {
+	ASSERT (intr_get_level () == INTR_OFF);
+
+	list_push_back (&wq->pending, &work->elem);
+	sema_up (&wq->work_sema);
+	// interrupt handler에서 깨운 worker가 더 높은 priority일 수 있으므로 반환 시 양보
+	if (intr_context ())
+		intr_yield_on_return ();
+}
+
+/* Worker thread for workqueue AUX: runs pending work forever. */
+static void
+worker_thread (void *wq_) {
+	struct workqueue *wq = wq_;
+
+	for (;;) {
+		struct work *work;
+		enum intr_level old_level;
+
+		sema_down (&wq->work_sema);
+
+		old_level = intr_disable ();
+		work = list_entry (list_pop_front (&wq->pending), struct work, elem);
+		// 실행 직전에 pending 상태를 풀어서 실행 중에 다시 queue될 수 있게 함
+		work->wq = NULL;
+		wq->running++;
+		intr_set_level (old_level);
+
+		work->func (work);
+
+		old_level = intr_disable ();
+		wq->running--;
+		if (list_empty (&wq->pending) && wq->running == 0)
+			for (; wq->flushers > 0; wq->flushers--)
+				sema_up (&wq->idle_sema);
+		intr_set_level (old_level);
+	}
+}
+
+/* Delayed work 정렬 기준: expiry가 빠른 work가 앞 (같으면 먼저 queue된 work가 앞) */
+static bool
+expires_less (const struct list_elem *a, const struct list_elem *b,
+		void *aux UNUSED) {
+	return list_entry (a, struct work, elem)->expires
+			< list_entry (b, struct work, elem)->expires;
+}
@@ -221,8 +221,11 @@ __do_fork (void *aux) {
 	current->max_fd = parent->max_fd;	
 
 	// fdt 가져오기: parent fdt의 file들을 current fdt에서 duplicate (아직 dup 를 고려하지 않음)
+	// parent가 FDT를 만든 적이 없다면 child도 처음 필요할 때 만듦
 	struct file *orig_file;
-	for (int i = 0; i <= parent->max_fd; i++) {
+	if (parent->fdt != NULL && !thread_alloc_fdt(current))
+		goto error;
+	for (int i = 0; parent->fdt != NULL && i <= parent->max_fd; i++) {
 		orig_file = parent->fdt[i];
 		if (i < 2) {
 			current->fdt[i] = orig_file;			
@@ -335,7 +338,7 @@ process_exit (void) {
 	 * TODO: We recommend you to implement process resource cleanup here. */
 	// fdt에서 열려있는 파일 닫기
 	struct file *file;
-	for (int fd = 0; fd <= curr->max_fd; fd++) {
+	for (int fd = 0; curr->fdt != NULL && fd <= curr->max_fd; fd++) {
 		_close(fd);
 
 		// file = curr->fdt[i];
@@ -345,8 +348,8 @@ process_exit (void) {
 		// 	file_close(file);
 		// }
 	}
-	// fdt에 할당된 kernel 영역의 메모리 회수하기
-	palloc_free_multiple(curr->fdt, FDT_PAGE_CNT);
+	// fdt에 할당된 kernel 영역의 메모리 회수하기 (재사용을 위해 cache로 돌려줌)
+	thread_free_fdt(curr);
 	// 실행 중이던 파일이 있다면 종료하기
 	file_close(curr->running_file);
 
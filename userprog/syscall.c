@@ -159,6 +159,10 @@ int process_add_file (struct file *file) {
 	if (curr->next_fd >= FDT_ENTRY_MAX) {
 		return TID_ERROR;	
 	}
+	/* 처음 파일을 여는 경우 FDT 생성 */
+	if (!thread_alloc_fdt(curr)) {
+		return TID_ERROR;
+	}
 	/* 현재 thread의 fdt에 새로운 파일 추가 */
 	int fd = curr->next_fd;
 	curr->fdt[fd] = file;
@@ -183,8 +187,13 @@ struct file *process_get_file (int fd) {
 	if (fd < 0 || fd >= FDT_ENTRY_MAX) {
 		return NULL;
 	}
+	/* 아직 FDT가 없다면 STDIN, STDOUT만 열려 있는 상태 */
+	struct file **fdt = thread_current()->fdt;
+	if (fdt == NULL) {
+		return fd == 0 ? FDT_STDIN : fd == 1 ? FDT_STDOUT : NULL;
+	}
 	/* 현재 thread의 fdt에서 fd 위치에 값이 있는지 확인 */
-	struct file *file = thread_current()->fdt[fd];
+	struct file *file = fdt[fd];
 	if (file == NULL) {
 		return NULL;
 	}
@@ -196,11 +205,14 @@ void process_close_file (int fd) {
 	/* fd 값이 유효한지 확인
 		- 일단 stdin, stdout은 삭제 불가 처리
 	 */
-	if (fd >= FDT_ENTRY_MAX) {
+	if (fd < 0 || fd >= FDT_ENTRY_MAX) {
 		return;
 	}
-	/* sdt에서 값 제거 */
+	/* sdt에서 값 제거 (FDT가 없다면 STDIN, STDOUT을 닫는 경우에만 생성) */
 	struct thread *curr = thread_current();
+	if (curr->fdt == NULL && (fd >= 2 || !thread_alloc_fdt(curr))) {
+		return;
+	}
 	curr->fdt[fd] = NULL;
 	/* stdin과 stdout를 삭제하더라도 next_fd가 0,1 자리에는 들어오지 못하도록 비워둠 (is it right?) */
 	if (fd < 2) {
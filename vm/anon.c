@@ -1,11 +1,15 @@
 /* anon.c: Implementation of page for non-disk image (a.k.a. anonymous page). */
 
 #include "vm/vm.h"
+#include <stdio.h>
 #include "devices/disk.h"
+#include "devices/timer.h"
 
 // ADD
 #include <round.h>
 #include <bitmap.h>
+#include "threads/malloc.h"
+#include "threads/mmu.h"
 // SECTORS_PER_PAGE: 한 PAGE를 수용하는데 필요한 disk sector의 수 (4096 bytes // 512 bytes)
 #define SECTORS_PER_PAGE DIV_ROUND_UP(PGSIZE, DISK_SECTOR_SIZE)
 #define INITIAL_SWAP_IDX -1
@@ -37,6 +41,16 @@ static const struct page_operations stack_ops = {
   - anon.c에서만 접근할 것이므로 static 으로 설정
 */
 static struct bitmap *swap_table;
+/* slot별로 그 slot을 가리키는 page의 수
+  - fork 시 swap out된 page를 공유하므로, 마지막 page가 떠날 때 slot을 비움
+*/
+static uint16_t *swap_refs;
+
+/* swap 처리량 통계 */
+static long long swap_in_cnt, swap_out_cnt;  /* swap in/out 한 page 수 */
+static int64_t swap_ns;                      /* swap I/O에 걸린 시간 */
+
+static void swap_slot_put (size_t swap_idx);
 
 /* Initialize the data for anonymous pages */
 void
@@ -53,6 +67,35 @@ vm_anon_init (void) {
 	// printf("[vm_anon_init] max_slot %d\n", max_slot);
 	// swap table 초기화
 	swap_table = bitmap_create(max_slot);
+	swap_refs = calloc(max_slot, sizeof *swap_refs);
+}
+
+/* Makes DST share SRC's swap slot, for fork. */
+void
+anon_share_swap (struct page *dst, struct page *src) {
+	size_t swap_idx = src->anon.swap_idx;
+
+	ASSERT (swap_idx != INITIAL_SWAP_IDX);
+	dst->anon.swap_idx = swap_idx;
+	swap_refs[swap_idx]++;
+}
+
+/* Prints swap statistics: pages moved and their I/O throughput. */
+void
+anon_print_stats (void) {
+	long long bytes = (swap_in_cnt + swap_out_cnt) * PGSIZE;
+	/* bytes / ns * 1000 = MB/s; keep two decimals. */
+	long long centi_mbps = swap_ns > 0 ? bytes * 100000 / swap_ns : 0;
+
+	printf ("Swap: %lld pages in, %lld pages out, %lld.%02lld MB/s\n",
+			swap_in_cnt, swap_out_cnt, centi_mbps / 100, centi_mbps % 100);
+}
+
+/* Drops one reference to SWAP_IDX, freeing the slot with the last. */
+static void
+swap_slot_put (size_t swap_idx) {
+	if (--swap_refs[swap_idx] == 0)
+		bitmap_set (swap_table, swap_idx, false);
 }
 
 /* Initialize the file mapping */
@@ -76,17 +119,14 @@ anon_swap_in (struct page *page, void *kva) {
 	if (anon_page->swap_idx == INITIAL_SWAP_IDX)
 		return false;
 	// swap disk에 있는 내용을 page에 옮겨 적기
-	// - page를 옮겨 적기 위해서는 SECTORS_PER_PAGE 개수의 sector가 필요함
-	// - 한 sector의 크기는 DISK_SECTOR_SIZE bytes임
-	disk_sector_t sec_no;
-	uintptr_t offset; // 주의! 자료형에 따라 값이 제대로 안 잡힐 수 있음
-	for (int i=0; i < SECTORS_PER_PAGE; i++) {
-		sec_no = anon_page->swap_idx * SECTORS_PER_PAGE + i;
-		offset = page->frame->kva + DISK_SECTOR_SIZE * i;
-		disk_read(swap_disk, sec_no, offset);
-	}
-	// swap table의 해당 위치가 비었음을 표시
-	bitmap_set(swap_table, anon_page->swap_idx, false);
+	// - SECTORS_PER_PAGE 개의 sector를 명령 하나로 한 번에 읽음
+	int64_t start = timer_now_ns();
+	disk_read_multiple(swap_disk, anon_page->swap_idx * SECTORS_PER_PAGE,
+			SECTORS_PER_PAGE, page->frame->kva);
+	swap_in_cnt++;
+	swap_ns += timer_now_ns() - start;
+	// swap table의 해당 위치가 비었음을 표시 (slot을 공유하는 page가 없을 때)
+	swap_slot_put(anon_page->swap_idx);
 	// printf("[anon_swap_in] end swap_idx %d\n", anon_page->swap_idx);
 	// swap_idx 초기화
 	anon_page->swap_idx = INITIAL_SWAP_IDX;
@@ -97,7 +137,6 @@ anon_swap_in (struct page *page, void *kva) {
 static bool
 anon_swap_out (struct page *page) {
 	// printf("[anon_swap_out] start %p, %p\n", page->va, page->frame->kva);
-	struct anon_page *anon_page = &page->anon;
 	// page 유효성 체크
 	if (page == NULL
 		|| page->frame == NULL
@@ -111,25 +150,28 @@ anon_swap_out (struct page *page) {
 	if (swap_idx == BITMAP_ERROR)
 		return false;
 	// page에 있는 내용을 disk에 옮겨 적기
-	// - page를 옮겨 적기 위해서는 SECTORS_PER_PAGE 개수의 sector가 필요함
-	// - 한 sector의 크기는 DISK_SECTOR_SIZE bytes임
-	disk_sector_t sec_no;
-	uintptr_t offset; // 주의! 자료형에 따라 값이 제대로 안 잡힐 수 있음
-	for (int i=0; i < SECTORS_PER_PAGE; i++) {
-		sec_no = swap_idx * SECTORS_PER_PAGE + i;
-		offset = page->frame->kva + DISK_SECTOR_SIZE * i;
-		disk_write(swap_disk, sec_no, offset);
-	}
+	// - SECTORS_PER_PAGE 개의 sector를 명령 하나로 한 번에 씀
+	int64_t start = timer_now_ns();
+	disk_write_multiple(swap_disk, swap_idx * SECTORS_PER_PAGE,
+			SECTORS_PER_PAGE, page->frame->kva);
+	swap_out_cnt++;
+	swap_ns += timer_now_ns() - start;
 	// swap table의 해당 위치에 page가 추가되었음을 표시
 	bitmap_set(swap_table, swap_idx, true);
-	// 나중에 swap in을 하기 위해 anon_page에 swap_idx 를 저장
-	anon_page->swap_idx = swap_idx;
-	// pml4에서 빠졌음을 표시
-	// pml4_clear_page(thread_current()->pml4, page->va);
-	pml4_clear_page(page->frame->thread->pml4, page->va);
+	// frame을 공유하던(COW) page들 모두 같은 slot을 가리키게 함
+	struct frame *frame = page->frame;
+	swap_refs[swap_idx] = frame->share_cnt;
+	struct list_elem *e;
+	for (e = list_begin (&frame->pages); e != list_end (&frame->pages); e = list_next (e)) {
+		struct page *p = list_entry (e, struct page, f_elem);
+		// 나중에 swap in을 하기 위해 anon_page에 swap_idx 를 저장
+		p->anon.swap_idx = swap_idx;
+		// pml4에서 빠졌음을 표시
+		pml4_clear_page(p->owner->pml4, p->va);
+		pml4_set_dirty (p->owner->pml4, p->va, false);
+		p->frame = NULL;
+	}
 	// printf("[anon_swap_out] done %p\n", page->va);
-	pml4_set_dirty (page->frame->thread->pml4, page->va, false);
-	page->frame = NULL;
 	return true;
 }
 
@@ -138,15 +180,15 @@ static void
 anon_destroy (struct page *page) {
 	struct anon_page *anon_page = &page->anon;
 	// frame에 할당되었던 메모리 해제
+	// - 다른 process와 공유 중이라면(COW) 참조만 끊음
 	if (page->frame != NULL) {
-		list_remove (&page->frame->elem);
-		free(page->frame);
+		vm_frame_unmap (page);
 	} 
 	// 만약 swap 되어 있었다면 
 	else {
 		struct anon_page *anon_page = &page->anon;
 		if (anon_page->swap_idx != INITIAL_SWAP_IDX) {
-			bitmap_set (swap_table, anon_page->swap_idx, false);
+			swap_slot_put (anon_page->swap_idx);
 		}
 	}
 }
@@ -67,16 +67,17 @@ static bool
 file_backed_swap_out (struct page *page) {
 	// printf("[file_backed_swap_out] %p\n", page->va);
 	struct file_page *file_page = &page->file;
+	uint64_t *pml4 = page->owner->pml4;
 	// 수정된 상태인지 확인하여 수정된 경우 file에 저장
-	if (pml4_is_dirty(page->frame->thread->pml4, page->va)) {
+	// - 다른 process의 page일 수 있으므로 va가 아닌 kva를 통해 씀
+	if (pml4_is_dirty(pml4, page->va)) {
 		file_seek(file_page->file, file_page->ofs);
-		file_write(file_page->file, page->va, file_page->size);
+		file_write(file_page->file, page->frame->kva, file_page->size);
 		// 다시 swap in 할 때는 저장된 상태에서 읽어올 것이므로, dirty false
-		pml4_set_dirty (page->frame->thread->pml4, page->va, false);
+		pml4_set_dirty (pml4, page->va, false);
 	}
 	// pml4에서 빠졌음을 표시
-	// pml4_clear_page(thread_current()->pml4, page->va);
-	pml4_clear_page(page->frame->thread->pml4, page->va);
+	pml4_clear_page(pml4, page->va);
 	page->frame = NULL;
 	return true;
 }
@@ -94,8 +95,7 @@ file_backed_destroy (struct page *page) {
 	file_close(file_page->file);
     // frame에 할당되었던 메모리 해제
 	if (page->frame != NULL) {
-		list_remove (&page->frame->elem);
-		free(page->frame);
+		vm_frame_unmap (page);
 	}
 }
 
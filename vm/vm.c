@@ -7,15 +7,67 @@
 // ADD
 #include <hash.h>
 #include <list.h>
+#include <stdio.h>
+#include <string.h>
+#include "devices/timer.h"
 #include "threads/mmu.h"
 #include "threads/synch.h"
+#include "threads/workqueue.h"
 
-/* frame_table */
-static struct list frame_table;
-/* evict victim 로직(clock algorithm) 관련 */
-static struct lock clock_lock; // race 방지를 위한 lock
+/* page replacement 관련 (two-list LRU approximation)
+  - 새 frame은 inactive list 끝에 들어가고, victim은 inactive list 앞에서부터 고름
+  - inactive list에서 다시 참조된 frame은 active list로 올라감
+  - active list는 주기적으로(그리고 inactive가 부족할 때) accessed bit로 aging 되어
+    참조되지 않은 frame이 inactive list로 내려감
+*/
+static struct list active_list;
+static struct list inactive_list;
+static size_t active_cnt, inactive_cnt;
+static struct lock lru_lock; // race 방지를 위한 lock: 두 list와 clock_elem을 보호
+/* -vm-clock 일 때는 inactive list 하나를 원형으로 도는 clock algorithm 사용 */
+bool vm_clock;
 static struct list_elem *clock_elem; // 마지막 탐색 위치부터 이어서하기 위해 보관
 
+/* inactive list에서 clean한 file page를 찾아볼 최대 후보 수 */
+#define LRU_CLEAN_SCAN 16
+/* victim 탐색을 포기하기 전까지 list를 도는 최대 횟수
+   - 모든 frame이 고정(pin)되어 있으면 lru_lock을 쥔 채 영원히 돌게 되므로 제한 */
+#define VICTIM_SCAN_PASSES 3
+/* 주기적 aging: VM_AGE_TICKS마다 active list 앞에서 최대 LRU_AGE_BATCH개를 검사 */
+#define VM_AGE_TICKS (TIMER_FREQ / 4)
+#define LRU_AGE_BATCH 64
+static struct workqueue *vm_wq;
+static struct work age_work;
+static bool age_queued;
+
+/* background page-out 관련 (kswapd)
+  - free user frame이 low watermark 아래로 떨어지면 vm_get_frame에서 깨우고,
+    kswapd는 high watermark까지 evict 해서 palloc에 돌려줌
+  - 따라서 fault 처리 중에는 대부분 바로 free frame을 얻게 됨 (direct reclaim 회피)
+*/
+static size_t low_wmark, high_wmark;
+static struct semaphore kswapd_sema;
+static bool kswapd_awake;
+/* evict와 page 해제(spt kill, munmap), COW 공유/복사가 같은 frame을 두고 겹치지 않도록 직렬화
+  - lock 순서: evict_lock -> share_lock -> lru_lock
+*/
+static struct lock evict_lock;
+
+/* 통계 */
+static long long fault_cnt;       /* vm_try_handle_fault 호출 수 */
+static long long evict_cnt;       /* evict 된 frame 수 */
+static long long evict_clean_cnt; /* 그 중 write back 없이 버린 file page 수 */
+static long long direct_cnt;      /* 그 중 fault 처리 중에 직접 evict 한 수 */
+
+static void lru_add (struct frame *frame, enum frame_lru lru);
+static void lru_del (struct frame *frame);
+static void vm_age (struct work *work);
+static void kswapd (void *aux);
+/* COW 관련: share_cnt를 보고 복사/해제를 결정하는 구간을 직렬화
+  - frame->pages(rmap)와 share_cnt 자체는 victim 탐색도 읽으므로 lru_lock을 함께 잡고 수정
+*/
+static struct lock share_lock;
+
 /* Initializes the virtual memory subsystem by invoking each subsystem's
  * intialize codes. */
 void
@@ -28,12 +80,33 @@ vm_init (void) {
 	register_inspect_intr ();
 	/* DO NOT MODIFY UPPER LINES. */
 	/* TODO: Your code goes here. */
-	// frame_table 초기화
+	// replacement list 초기화
 	// - 정적 변수로 정의된 상태 (만약 malloc으로 할당한다면 여기서 처리)
-	list_init(&frame_table); 
-	// clock lock 초기화
-	lock_init(&clock_lock);
+	list_init(&active_list);
+	list_init(&inactive_list);
+	lock_init(&lru_lock);
 	clock_elem = NULL;
+	lock_init(&share_lock);
+	// 주기적 aging은 user frame이 생긴 뒤부터 돌림 (vm_get_frame)
+	vm_wq = workqueue_create("vm", 1, PRI_DEFAULT);
+	work_init(&age_work, vm_age);
+	// watermark: user pool의 1/32 (최소 4 frame)부터 그 2배까지 비워 둠
+	low_wmark = palloc_user_pages() / 32;
+	if (low_wmark < 4)
+		low_wmark = 4;
+	high_wmark = low_wmark * 2;
+	sema_init(&kswapd_sema, 0);
+	lock_init(&evict_lock);
+	thread_create("kswapd", PRI_DEFAULT, kswapd, NULL);
+}
+
+/* Prints virtual memory statistics. */
+void
+vm_print_stats (void) {
+	printf ("VM: %lld faults, %lld evictions (%lld clean file, %lld direct), %s\n",
+			fault_cnt, evict_cnt, evict_clean_cnt, direct_cnt,
+			vm_clock ? "clock" : "active/inactive LRU");
+	anon_print_stats ();
 }
 
 /* Get the type of the page. This function is useful if you want to know the
@@ -54,6 +127,10 @@ page_get_type (struct page *page) {
 static struct frame *vm_get_victim (void);
 static bool vm_do_claim_page (struct page *page);
 static struct frame *vm_evict_frame (void);
+static void frame_link (struct frame *frame, struct page *page);
+static int frame_unlink (struct frame *frame, struct page *page);
+static void frame_unpin (struct frame *frame);
+static bool frame_test_and_clear_accessed (struct frame *frame);
 
 /* Create the pending page object with initializer. If you want to create a
  * page, do not create it directly and make it through this function or
@@ -136,51 +213,172 @@ void
 spt_remove_page (struct supplemental_page_table *spt, struct page *page) {
 	struct hash_elem *e;
 	e = hash_delete(&spt->page_table, &page->h_elem);
+	lock_acquire(&evict_lock);
 	vm_dealloc_page (page);
+	lock_release(&evict_lock);
 	return true;
 }
 
-/* Get the struct frame, that will be evicted. */
+/* Adds FRAME to the tail of the LRU list. lru_lock must be held. */
+static void
+lru_add (struct frame *frame, enum frame_lru lru) {
+	ASSERT (frame->lru == LRU_NONE);
+	if (lru == LRU_ACTIVE) {
+		list_push_back (&active_list, &frame->elem);
+		active_cnt++;
+	} else {
+		list_push_back (&inactive_list, &frame->elem);
+		inactive_cnt++;
+	}
+	frame->lru = lru;
+}
+
+/* Removes FRAME from its LRU list, if any. lru_lock must be held. */
+static void
+lru_del (struct frame *frame) {
+	if (frame->lru == LRU_NONE)
+		return;
+	if (clock_elem == &frame->elem)
+		clock_elem = list_next (clock_elem);
+	list_remove (&frame->elem);
+	if (frame->lru == LRU_ACTIVE)
+		active_cnt--;
+	else
+		inactive_cnt--;
+	frame->lru = LRU_NONE;
+}
+
+/* Returns true if FRAME holds a file-backed page that can be
+   dropped without writing it back. */
+static bool
+frame_is_clean_file (struct frame *frame) {
+	struct page *page = frame->page;
+	return page_get_type (page) == VM_FILE
+		&& !pml4_is_dirty (page->owner->pml4, page->va);
+}
+
+/* Ages up to CNT frames from the head of the active list: frames
+   referenced since the last look stay active, the rest move to
+   the inactive list.  lru_lock must be held. */
+static void
+lru_age_active (size_t cnt) {
+	while (cnt-- > 0 && !list_empty (&active_list)) {
+		struct frame *frame = list_entry (list_front (&active_list),
+				struct frame, elem);
+		bool referenced = frame->pin_cnt > 0 || frame->share_cnt == 0
+			|| frame_test_and_clear_accessed (frame);
+		lru_del (frame);
+		lru_add (frame, referenced ? LRU_ACTIVE : LRU_INACTIVE);
+	}
+}
+
+/* Scans the inactive list from its head for a victim.  Referenced
+   frames are promoted to the active list.  Among the first
+   LRU_CLEAN_SCAN unreferenced frames, a clean file-backed one is
+   preferred, because it needs no disk write; otherwise the oldest
+   one is returned.  Returns NULL if every frame was referenced.
+   lru_lock must be held. */
+static struct frame *
+lru_scan_inactive (void) {
+	struct frame *oldest = NULL;
+	int candidates = 0;
+	struct list_elem *e = list_begin (&inactive_list);
+
+	while (e != list_end (&inactive_list) && candidates < LRU_CLEAN_SCAN) {
+		struct frame *frame = list_entry (e, struct frame, elem);
+		e = list_next (e);
+		if (frame->pin_cnt > 0 || frame->share_cnt == 0)
+			continue;
+		if (frame_test_and_clear_accessed (frame)) {
+			lru_del (frame);
+			lru_add (frame, LRU_ACTIVE);
+			continue;
+		}
+		if (frame_is_clean_file (frame))
+			return frame;
+		if (oldest == NULL)
+			oldest = frame;
+		candidates++;
+	}
+	return oldest;
+}
+
+/* Periodic aging work: keeps the active list's accessed bits
+   meaningful even when nothing is being evicted. */
+static void
+vm_age (struct work *work UNUSED) {
+	lock_acquire (&lru_lock);
+	lru_age_active (LRU_AGE_BATCH);
+	age_queued = active_cnt > 0;
+	if (age_queued)
+		queue_delayed_work (vm_wq, &age_work, VM_AGE_TICKS);
+	lock_release (&lru_lock);
+}
+
+/* Get the struct frame, that will be evicted.  Gives up and
+   returns NULL after VICTIM_SCAN_PASSES passes, e.g. when every
+   frame is pinned, since frame_unpin() needs lru_lock. */
 static struct frame *
 vm_get_victim (void) {
-	// printf("[vm_get_victim] start\n");
-	/* TODO: The policy for eviction is up to you. */
-	struct thread *curr = thread_current();
-	struct frame *victim;
-	// thread 간 race problem을 방지하기 위해 lock으로 접근을 통제
-	lock_acquire(&clock_lock);
+	struct frame *victim = NULL;
+	int pass;
+
+	lock_acquire (&lru_lock);
+	// evict 할 수 있는 frame이 없음
+	if (active_cnt + inactive_cnt == 0) {
+		lock_release (&lru_lock);
+		return NULL;
+	}
+	if (!vm_clock) {
+		// inactive list가 active list보다 작으면 aging으로 보충한 뒤 victim 탐색
+		// - 모두 참조되어 active로 올라갔다면 다시 aging하고 반복 (최대 VICTIM_SCAN_PASSES번)
+		for (pass = 0; pass < VICTIM_SCAN_PASSES; pass++) {
+			if (inactive_cnt < active_cnt)
+				lru_age_active (active_cnt - inactive_cnt);
+			victim = lru_scan_inactive ();
+			if (victim != NULL)
+				break;
+			lru_age_active (active_cnt);
+		}
+		if (victim != NULL)
+			lru_del (victim);
+		lock_release (&lru_lock);
+		return victim;
+	}
+
+	// 이하 clock algorithm: inactive list 하나를 원형으로 순회
 	// 마지막 탐색 위치부터 탐색 시작
 	struct list_elem *e = clock_elem;
-	// frame_table을 하나씩 돌며 access되지 않은 frame 찾기
-	// - current thread에서 accessed 여부를 체크
-	// - 즉 현재 로직에서는 current thread가 아닌 다른 thread의 page는 바로 victim으로 처리됨
-	// - 만약 다른 프로세스도 포함시키고 싶다면 frame 구조체에 thread member를 추가해주면 될 듯
-	// - [실험] frame에서 thread를 관리하는 방향으로 시도!!
+	// inactive list를 하나씩 돌며 access되지 않은 frame 찾기
+	// - rmap(frame->pages)을 따라 frame을 mapping한 모든 pml4의 accessed bit를 체크
 	bool found = false;
-	while (!found) {
-		if (e == NULL || e == list_end(&frame_table))
-			e = list_begin(&frame_table);
+	for (pass = 0; !found && pass < VICTIM_SCAN_PASSES; pass++) {
+		if (e == NULL || e == list_end(&inactive_list))
+			e = list_begin(&inactive_list);
 		// 한 바퀴 돌면서 victim을 못 찾지 못한 경우(즉 모두 accessed 였던 경우) 반복해 순회 
-		//  - 최대 for loop 이 3번 시작됨
+		//  - 모든 frame이 고정되어 있다면 VICTIM_SCAN_PASSES번 돈 뒤 포기
 		for (clock_elem = e; 
-		clock_elem != list_end(&frame_table); 
+		clock_elem != list_end(&inactive_list); 
 		clock_elem = list_next(clock_elem)) {
 			victim = list_entry (clock_elem, struct frame, elem);
-			if (pml4_is_accessed(curr->pml4, victim->page->va))	{
-				pml4_set_accessed(curr->pml4, victim->page->va, 0);
-			// if (pml4_is_accessed(victim->thread->pml4, victim->page->va)) {
-			// 	pml4_set_accessed(victim->thread->pml4, victim->page->va, 0);
-			} else {
+			// COW 복사 중이거나 아직 page와 연결되기 전인 frame은 건너뜀
+			if (victim->pin_cnt > 0 || victim->share_cnt == 0)
+				continue;
+			if (!frame_test_and_clear_accessed(victim)) {
 				// 현재 victim으로 탐색 종료
 				found = true;
 				break;
 			}
 		}
+		e = clock_elem;
 	}
-	// 다음 elem로 옮겨 둚
-	clock_elem = list_next(clock_elem);
-	// 
-	lock_release(&clock_lock);
+	if (!found) {
+		lock_release(&lru_lock);
+		return NULL;
+	}
+	// victim을 list에서 빼면서 clock_elem은 다음 elem로 옮겨짐
+	lru_del(victim);
+	lock_release(&lru_lock);
 	// printf("[vm_get_victim] end %p\n", victim);
 	return victim;
 }
@@ -189,10 +387,16 @@ vm_get_victim (void) {
  * Return NULL on error.*/
 static struct frame *
 vm_evict_frame (void) {
+	lock_acquire(&evict_lock);
 	struct frame *victim = vm_get_victim ();
 	/* TODO: swap out the victim and return the evicted frame. */
-	if (victim == NULL)
+	if (victim == NULL) {
+		lock_release(&evict_lock);
 		return NULL;
+	}
+	evict_cnt++;
+	if (frame_is_clean_file(victim))
+		evict_clean_cnt++;
 	// swap out 처리: page type에 맞게 처리됨
 	if (!swap_out(victim->page))
 		PANIC("fail to swap out.. maybe swap disk is full.");
@@ -201,29 +405,59 @@ vm_evict_frame (void) {
 	// - 주의! frame을 비워주지 않는다면 서로 다른 process 간에 침범이 발생할 수 있음
 	// - 가령, swap out된 process B의 page를 process A가 볼 수도 있음
 	victim->page = NULL;
-	victim->thread = NULL;
+	list_init(&victim->pages);
+	victim->share_cnt = 0;
+	lock_release(&evict_lock);
 	memset(victim->kva, 0, PGSIZE);
 
 	return victim;
 }
 
+/* Background page-out thread.  Sleeps until vm_get_frame() sees
+   the free user frames fall below low_wmark, then evicts frames
+   and returns them to the page allocator until high_wmark frames
+   are free again. */
+static void
+kswapd (void *aux UNUSED) {
+	for (;;) {
+		sema_down (&kswapd_sema);
+		while (palloc_user_free_pages () < high_wmark) {
+			struct frame *frame = vm_evict_frame ();
+			if (frame == NULL)
+				break;
+			palloc_free_page (frame->kva);
+			free (frame);
+		}
+		kswapd_awake = false;
+	}
+}
+
 /* palloc() and get frame. If there is no available page, evict the page
- * and return it. This always return valid address. That is, if the user pool
- * memory is full, this function evicts the frame to get the available memory
- * space.*/
+ * and return it. That is, if the user pool memory is full, this function
+ * evicts the frame to get the available memory space.  Returns NULL if no
+ * frame can be evicted, e.g. because every frame is pinned.
+ * The frame comes back pinned, so that kswapd cannot evict it while the
+ * caller fills it; the caller releases it with frame_unpin(). */
 static struct frame *
 vm_get_frame (void) {
 	// 물리메모리의 유저 영역에서 page 하나를 할당 받음
 	struct page *phys_page;
 	phys_page = palloc_get_page(PAL_USER);
+	// free frame이 low watermark 아래로 떨어지면 kswapd를 깨움
+	if (!kswapd_awake && palloc_user_free_pages() < low_wmark) {
+		kswapd_awake = true;
+		sema_up(&kswapd_sema);
+	}
 	// frame을 구성
 	struct frame *frame;
-	// page 할당에 실패한 경우 (이미 가득찬 경우)
+	// page 할당에 실패한 경우 (kswapd가 따라잡지 못해 가득찬 경우)
+	// - 기존의 frame 중 victim을 정해 직접 swap out 처리 후 재활용 
 	if (phys_page == NULL) {
-		// 임시로 PANIC 처리
-		// PANIC("TODO: vm_evict_frame");
-		// TODO: 기존의 frame 중 victim을 정해 swap out 처리 후 재활용 
 		frame = vm_evict_frame();
+		// 모든 frame이 고정되어 evict 할 수 없는 경우: 호출자가 fault를 실패 처리
+		if (frame == NULL)
+			return NULL;
+		direct_cnt++;
 	} 
 	// page 할당에 성공한 경우
 	else {
@@ -231,18 +465,40 @@ vm_get_frame (void) {
 		frame = (struct frame *)malloc(sizeof(struct frame));
 		frame->kva = phys_page;
 		frame->page = NULL; // 여기의 page는 phys_page에 들어갈 가상 주소 공간의 page
-		frame->thread = NULL; // 실험적 코드
-		// 새로 생성한 frame을 frame_table에 추가
-		// - 일단 push_back으로 처리하되, 추후 victim 정하는 정책에 맞게 수정
-		list_push_back(&frame_table, &frame->elem);
+		list_init(&frame->pages);
+		frame->share_cnt = 0;
+		frame->pin_cnt = 0;
+		frame->lru = LRU_NONE;
 	}
 	
 	ASSERT (frame != NULL);
 	ASSERT (frame->page == NULL);
 
+	// 새로 받은 frame(또는 evict 후 재활용하는 frame)을 inactive list 끝에 추가
+	// - 참조되면 다음 scan에서 active list로 올라감
+	// - 내용을 채우는 동안(swap_in, COW 복사) evict 되지 않도록 고정해서 넘겨줌
+	lock_acquire(&lru_lock);
+	frame->pin_cnt++;
+	lru_add(frame, LRU_INACTIVE);
+	if (!vm_clock && !age_queued) {
+		age_queued = true;
+		queue_delayed_work(vm_wq, &age_work, VM_AGE_TICKS);
+	}
+	lock_release(&lru_lock);
+
 	return frame;
 }
 
+/* Releases a pin taken by vm_get_frame(), making FRAME evictable
+   again. */
+static void
+frame_unpin (struct frame *frame) {
+	lock_acquire (&lru_lock);
+	ASSERT (frame->pin_cnt > 0);
+	frame->pin_cnt--;
+	lock_release (&lru_lock);
+}
+
 /* Growing the stack. */
 static void
 vm_stack_growth (void *addr) {
@@ -267,9 +523,63 @@ error:
 	PANIC("vm_stack_growth fail");
 }
 
-/* Handle the fault on write_protected page */
+/* Handle the fault on write_protected page
+  - fork 이후 read-only로 공유 중인 frame에 write 한 경우 (copy-on-write)
+  - 공유하는 page가 더 남아 있으면 새 frame에 복사하고, 혼자 남았다면 쓰기 권한만 되돌림
+*/
 static bool
-vm_handle_wp (struct page *page UNUSED) {
+vm_handle_wp (struct page *page) {
+	struct thread *t = thread_current ();
+	struct frame *old;
+	struct frame *new;
+	bool success;
+
+	// eviction과 겹치지 않도록 evict_lock을 잡은 채로 frame을 확인하고 고정
+	lock_acquire (&evict_lock);
+	old = page->frame;
+	if (old == NULL) {
+		// fault 이후 swap out 되었다면 swap in 하면서 자기 frame을 받으면 됨
+		lock_release (&evict_lock);
+		return vm_do_claim_page (page);
+	}
+	lock_acquire (&share_lock);
+	if (old->share_cnt == 1) {
+		pml4_clear_page (t->pml4, page->va);
+		success = pml4_set_page (t->pml4, page->va, old->kva, true);
+		lock_release (&share_lock);
+		lock_release (&evict_lock);
+		return success;
+	}
+	lock_release (&share_lock);
+	// 복사하는 동안 old frame이 evict 되지 않도록 고정 (victim 탐색과 같은 lru_lock)
+	lock_acquire (&lru_lock);
+	old->pin_cnt++;
+	lock_release (&lru_lock);
+	lock_release (&evict_lock);
+
+	new = vm_get_frame ();
+	if (new == NULL) {
+		frame_unpin (old);
+		return false;
+	}
+	memcpy (new->kva, old->kva, PGSIZE);
+
+	lock_acquire (&share_lock);
+	// 그 사이 다른 page들이 모두 떠났다면 old frame은 더 이상 아무도 mapping하지 않음
+	if (frame_unlink (old, page) == 0) {
+		palloc_free_page (old->kva);
+		free (old);
+	} else
+		frame_unpin (old);
+	new->page = page;
+	frame_link (new, page);
+	lock_release (&share_lock);
+
+	pml4_clear_page (t->pml4, page->va);
+	success = pml4_set_page (t->pml4, page->va, new->kva, true);
+	// mapping까지 끝난 뒤에야 evict 대상이 될 수 있음
+	frame_unpin (new);
+	return success;
 }
 
 /* On page fault, the page fault handler (page_fault in userprog/exception.c) 
@@ -283,6 +593,7 @@ vm_handle_wp (struct page *page UNUSED) {
 bool
 vm_try_handle_fault (struct intr_frame *f UNUSED, void *addr,
 		bool user, bool write, bool not_present) {
+	fault_cnt++;
 	// printf("[vm_try_handle_fault] hello! %p, %p, %d, %d, %d\n", f->rsp, addr, user, write, not_present);
 	struct supplemental_page_table *spt = &thread_current ()->spt;
 	struct page *page;
@@ -323,6 +634,9 @@ vm_try_handle_fault (struct intr_frame *f UNUSED, void *addr,
 	}
 	// printf("[vm_try_handle_fault] found page! %p, %p, %d, %d\n", 
 	// 	page->va, addr, page->operations->type, page->uninit.type);
+	// 이미 mapping된 page에 대한 fault: 쓰기 가능한 page라면 COW로 공유 중인 경우
+	if (!not_present)
+		return write && page->writable && vm_handle_wp (page);
 	
 	return vm_do_claim_page (page);
 }
@@ -350,6 +664,77 @@ vm_claim_page (void *va) {
 	return vm_do_claim_page (page);
 }
 
+/* Adds PAGE, owned by the current thread, to FRAME's mappings.
+   share_lock must be held. */
+static void
+frame_link (struct frame *frame, struct page *page) {
+	page->frame = frame;
+	page->owner = thread_current ();
+	lock_acquire (&lru_lock);
+	list_push_back (&frame->pages, &page->f_elem);
+	frame->share_cnt++;
+	lock_release (&lru_lock);
+}
+
+/* Removes PAGE from FRAME's mappings and returns the number of
+   mappings left.  When none are left, FRAME is also removed from
+   its LRU list; the caller owns it from then on.
+   share_lock must be held. */
+static int
+frame_unlink (struct frame *frame, struct page *page) {
+	int left;
+
+	// rmap을 걷는 victim 탐색/aging과 겹치지 않도록 lru_lock을 잡고 뗌
+	// - 그래야 탐색 중인 page가 해제되지 않음
+	lock_acquire (&lru_lock);
+	list_remove (&page->f_elem);
+	if (--frame->share_cnt == 0)
+		lru_del (frame);
+	else if (frame->page == page) {
+		// 대표 page가 떠나면 남은 page 중 하나로 교체
+		frame->page = list_entry (list_front (&frame->pages), struct page, f_elem);
+	}
+	left = frame->share_cnt;
+	lock_release (&lru_lock);
+	page->frame = NULL;
+	return left;
+}
+
+/* Returns true if any mapping of FRAME was accessed since the
+   last call, clearing the accessed bit of every mapping.
+   lru_lock must be held, which keeps FRAME's mappings alive. */
+static bool
+frame_test_and_clear_accessed (struct frame *frame) {
+	struct list_elem *e;
+	bool accessed = false;
+
+	for (e = list_begin (&frame->pages); e != list_end (&frame->pages);
+			e = list_next (e)) {
+		struct page *p = list_entry (e, struct page, f_elem);
+		if (pml4_is_accessed (p->owner->pml4, p->va)) {
+			pml4_set_accessed (p->owner->pml4, p->va, false);
+			accessed = true;
+		}
+	}
+	return accessed;
+}
+
+/* Drops PAGE's reference to its frame, for page destruction.
+   The last reference frees the frame; its kva is still released
+   by pml4_destroy().  Otherwise only PAGE's PTE is cleared, so
+   that pml4_destroy() leaves the still-shared kva alone. */
+void
+vm_frame_unmap (struct page *page) {
+	struct frame *frame = page->frame;
+
+	lock_acquire (&share_lock);
+	if (frame_unlink (frame, page) == 0)
+		free (frame);
+	else
+		pml4_clear_page (page->owner->pml4, page->va);
+	lock_release (&share_lock);
+}
+
 /* Claim the PAGE and set up the mmu. */
 static bool
 vm_do_claim_page (struct page *page) {
@@ -357,10 +742,14 @@ vm_do_claim_page (struct page *page) {
 	//  - 여기서 page는 supplemental page table에 있지만, 
 	//  - 아직 page table(pml4)에는 등록되지 않은, 즉 물리 메모리 (혹은 disk) 상에는 올라가지 않은 상태
 	struct frame *frame = vm_get_frame ();
+	if (frame == NULL)
+		return false;
 
 	/* Set links */
 	frame->page = page;
-	page->frame = frame;
+	lock_acquire (&share_lock);
+	frame_link (frame, page);
+	lock_release (&share_lock);
 
 	/* TODO: Insert page table entry to map page's VA to frame's PA. */
 	// 현재 thread의 page table(pml4)에 pte 추가하기
@@ -368,16 +757,17 @@ vm_do_claim_page (struct page *page) {
 	//  - 이 때, page table에 이미 동일한 가상 주소가 추가되어 있는지 사전 체크
 	//  - 2주차 코드 중 install_page 참고
 	struct thread *t = thread_current();
+	bool success = false;
 	if (pml4_get_page (t->pml4, page->va) == NULL
 		&& pml4_set_page (t->pml4, page->va, frame->kva, page->writable)) {
-		// 실험적 코드
-		frame->thread = thread_current();
 		// printf("[vm_do_claim_page] before swap_in %p %p\n", page->va, frame->kva);
-		return swap_in (page, frame->kva);
+		// swap_in(lazy load 또는 swap disk 읽기)이 끝날 때까지 frame은 고정된 상태
+		success = swap_in (page, frame->kva);
 	}
 	// page table에 추가 실패 시 처리
 	// printf("[vm_do_claim_page] fail swap_in\n");
-	return false;	
+	frame_unpin (frame);
+	return success;	
 }
 
 /* Initialize new supplemental page table 
@@ -438,13 +828,30 @@ supplemental_page_table_copy (struct supplemental_page_table *dst,
 				return false;
 			// 새로 할당된 child_page의 주소값 찾기
 			struct page *c_page = spt_find_page(dst, p_page->va);
-			// 새로운 child_page를 바로 물리메모리에 배치시킴
-			if (!vm_do_claim_page(c_page))
+			// lazy load할 내용이 없으므로 uninit 단계를 건너뛰고 바로 anon page로 만듦
+			anon_initializer(c_page, p_type, NULL);
+			// parent page의 frame을 보고 공유하는 동안 evict 되지 않도록 evict_lock을 잡음
+			lock_acquire(&evict_lock);
+			// parent page가 swap out 되어 있는 경우: 같은 swap slot을 공유
+			// - 먼저 swap in 하는 쪽이 자기 frame으로 읽어 감
+			if (p_page->frame == NULL) {
+				anon_share_swap(c_page, p_page);
+				lock_release(&evict_lock);
+				continue;
+			}
+			// 물리메모리에 있는 경우: 복사하지 않고 frame을 공유 (copy-on-write)
+			// - 양쪽 모두 read-only로 mapping해 두고, write 시 vm_handle_wp에서 복사
+			struct frame *frame = p_page->frame;
+			lock_acquire(&share_lock);
+			frame_link(frame, c_page);
+			lock_release(&share_lock);
+			bool mapped = pml4_set_page(thread_current()->pml4, c_page->va, frame->kva, false);
+			// parent 쪽을 read-only로 바꾸지 못하면 parent의 write가 child에게 보이므로 fork 실패
+			if (mapped && p_page->writable)
+				mapped = pml4_set_page(p_page->owner->pml4, p_page->va, frame->kva, false);
+			lock_release(&evict_lock);
+			if (!mapped)
 				return false;
-			// parent page를 child page에 복사함
-			// - 만약 parent page가 disk로 swap 되어 있었다면 어떻게 하지? 
-			// - memcpy 전에 parent page도 물리메모리에 올려놓도록 조치를 해야할까?
-			memcpy(c_page->frame->kva, p_page->frame->kva, PGSIZE);
 		} else if (VM_TYPE(p_type) == VM_FILE) {
 			printf("[spt_copy] VM_FILE! %d\n", p_type);
 			// TODO: 일단 아무 것도 하지 않음
@@ -471,7 +878,10 @@ void
 supplemental_page_table_kill (struct supplemental_page_table *spt) {
 	/* TODO: Destroy all the supplemental_page_table hold by thread and
 	 * TODO: writeback all the modified contents to the storage. */
+	// kswapd가 evict 중인 page를 해제하지 않도록 evict_lock을 잡고 진행
+	lock_acquire(&evict_lock);
 	hash_destroy(&spt->page_table, page_destroy);
+	lock_release(&evict_lock);
 }
 
 /* Returns a hash of element's data, as a value anywhere in the range of unsigned int */ 